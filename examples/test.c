@@ -408,7 +408,7 @@ overlay_attached(struct rtb_element *self,
 		struct rtb_element *parent, struct rtb_window *window)
 {
 	overlay_super.attached(self, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.test.overlay");
 }
 
@@ -0,0 +1,101 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * times rtb_is_type() against a chain of types to show that the cost of
+ * a subtype check doesn't grow with the depth of the hierarchy.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <rutabaga/rutabaga.h>
+#include <rutabaga/window.h>
+#include <rutabaga/atom.h>
+
+#define MAX_DEPTH  64
+#define ITERATIONS 10000000
+
+static double
+time_checks(struct rtb_type_atom_descriptor *desc,
+		struct rtb_type_atom *atom, int *matches)
+{
+	uint64_t start;
+	int i, n;
+
+	n = 0;
+	start = uv_hrtime();
+
+	for (i = 0; i < ITERATIONS; i++)
+		n += rtb_is_type(desc, atom);
+
+	*matches = n;
+	return (double) (uv_hrtime() - start) / ITERATIONS;
+}
+
+int main(int argc, char **argv)
+{
+	struct rtb_type_atom_descriptor *chain[MAX_DEPTH], *unrelated;
+	struct rtb_type_atom atom;
+	struct rtb_window win;
+	struct rutabaga *rtb;
+	char name[32];
+	int i, depth, hits, misses;
+	double hit_ns, miss_ns;
+
+	rtb = rtb_new();
+	assert(rtb);
+
+	/* types are registered against a window but only the window's
+	 * rutabaga is looked at, so there's no need to open one here. */
+	win.rtb = rtb;
+
+	chain[0] = rtb_type_ref(&win, NULL, "bench-0");
+	for (i = 1; i < MAX_DEPTH; i++) {
+		snprintf(name, sizeof(name), "bench-%d", i);
+		chain[i] = rtb_type_ref(&win, chain[i - 1], name);
+	}
+
+	unrelated = rtb_type_ref(&win, NULL, "bench-unrelated");
+
+	printf("%8s %12s %12s\n", "depth", "hit (ns)", "miss (ns)");
+
+	for (depth = 1; depth < MAX_DEPTH; depth *= 2) {
+		atom.type = chain[depth];
+
+		/* the root of the chain is the worst case for a walk up the
+		 * supertypes, and so is a type that isn't there at all. */
+		hit_ns  = time_checks(chain[0], &atom, &hits);
+		miss_ns = time_checks(unrelated, &atom, &misses);
+
+		assert(hits == ITERATIONS && !misses);
+		printf("%8d %12.2f %12.2f\n", depth, hit_ns, miss_ns);
+	}
+
+	rtb_free(rtb);
+	return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <rutabaga/animation.h>
+
+typedef enum {
+	RTB__TRANSITION_BG_COLOR = 0,
+	RTB__TRANSITION_BORDER_COLOR,
+
+	RTB__TRANSITION_COUNT
+} rtb__transition_slot_t;
+
+/**
+ * steps every running animation in the window to the current frame.
+ */
+void rtb__animation_tick(struct rtb_window *);
+
+/**
+ * points `*dest` (one of the element's stylequad colours) at `to`. if
+ * the element is restyling because its state changed, and its style
+ * sets `transition-duration`, fades over to `to` from whatever `*dest`
+ * shows now instead.
+ *
+ * returns -1 if `*dest` was already headed for `to`.
+ */
+int rtb__transition_color(struct rtb_element *, rtb__transition_slot_t,
+		const struct rtb_rgb_color **dest, const struct rtb_rgb_color *to);
+
+/**
+ * stops any transitions and puts their colours back where they were
+ * headed.
+ */
+void rtb__transitions_free(struct rtb_element *);
@@ -0,0 +1,49 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <rutabaga/frame-stats.h>
+
+void rtb__frame_stats_init(struct rtb_frame_stats *);
+
+/**
+ * rtb_window_draw() times the frame as it goes. the frame only goes into
+ * the history once it's drawn; frames that turn out to have nothing to
+ * draw are forgotten.
+ */
+void rtb__frame_stats_begin(struct rtb_frame_stats *, uint64_t now);
+void rtb__frame_stats_mark(struct rtb_frame_stats *, rtb_frame_phase_t);
+void rtb__frame_stats_drawn(struct rtb_frame_stats *, unsigned restyled);
+
+/**
+ * the platform reports these for the last frame drawn, after
+ * rtb_window_draw() returns 1. `when` is on the uv_hrtime() clock.
+ */
+void rtb__frame_stats_swapped(struct rtb_frame_stats *);
+void rtb__frame_stats_presented(struct rtb_frame_stats *, uint64_t when);
@@ -0,0 +1,59 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <rutabaga/font-manager.h>
+
+#ifdef RTB_GLYPH_CACHE
+
+/**
+ * rasterised glyphs are kept on disk, keyed by the font's contents, size,
+ * DPI and atlas depth, so that fonts don't have to go through FreeType
+ * every time a window opens.
+ *
+ * load copies whatever the cache has for `txfont` straight into the atlas
+ * and returns how many glyphs that was, or -1 if there's nothing usable.
+ * save writes out every glyph `txfont` currently has.
+ */
+int rtb__glyph_cache_load(struct rtb_texture_font *txfont);
+int rtb__glyph_cache_save(struct rtb_texture_font *txfont);
+
+#else
+
+static inline int
+rtb__glyph_cache_load(struct rtb_texture_font *txfont)
+{
+	return -1;
+}
+
+static inline int
+rtb__glyph_cache_save(struct rtb_texture_font *txfont)
+{
+	return -1;
+}
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <rutabaga/element.h>
+
+/**
+ * elements with at least this many children hit-test them through a
+ * grid instead of checking each one in turn.
+ */
+#define RTB_HIT_GRID_THRESHOLD 64
+
+/**
+ * returns the top-most visible child of `parent` that contains `pt`, or
+ * NULL if there isn't one. builds the grid if `parent` doesn't have one
+ * yet.
+ */
+struct rtb_element *rtb__hit_grid_child_at(struct rtb_element *parent,
+		struct rtb_point pt);
+
+/**
+ * keeps `child` in step with its parent's grid after it has moved or
+ * been added. does nothing if the parent doesn't have a grid.
+ */
+void rtb__hit_grid_update(struct rtb_element *parent,
+		struct rtb_element *child);
+void rtb__hit_grid_remove(struct rtb_element *parent,
+		struct rtb_element *child);
+
+void rtb__hit_grid_free(struct rtb_element *parent);
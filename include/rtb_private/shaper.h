@@ -0,0 +1,106 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <rutabaga/types.h>
+#include <rutabaga/font-manager.h>
+
+/**
+ * positions are in pixels at the atlas DPI, the same units as
+ * texture_glyph_t's metrics.
+ */
+struct rtb_shaped_glyph {
+	uint32_t glyph_index;
+
+	/* index of the first codepoint of this glyph's cluster, relative
+	 * to the start of the run */
+	uint32_t cluster;
+
+	float x_advance;
+	float x_offset, y_offset;
+};
+
+struct rtb_shaped_run {
+	unsigned nglyphs;
+	struct rtb_shaped_glyph glyphs[];
+};
+
+#ifdef RTB_HARFBUZZ
+
+/**
+ * shapes `len` codepoints of `text` with `font`. runs are cached by font
+ * and text, so repeatedly shaping the same strings is cheap. the returned
+ * run is owned by the cache and only valid until the next call.
+ *
+ * returns NULL if shaping isn't possible, in which case callers should
+ * fall back to laying out codepoints directly.
+ */
+const struct rtb_shaped_run *rtb__shaper_shape(struct rtb_font_manager *,
+		struct rtb_texture_font *font, const rtb_utf32_t *text, size_t len);
+
+/**
+ * drops everything the shaper holds for `font`. has to be called whenever
+ * the underlying texture_font_t is replaced or freed.
+ */
+void rtb__shaper_forget_font(struct rtb_font_manager *,
+		struct rtb_texture_font *font);
+
+int rtb__shaper_init(struct rtb_font_manager *);
+void rtb__shaper_fini(struct rtb_font_manager *);
+
+#else
+
+static inline const struct rtb_shaped_run *
+rtb__shaper_shape(struct rtb_font_manager *fm,
+		struct rtb_texture_font *font, const rtb_utf32_t *text, size_t len)
+{
+	return NULL;
+}
+
+static inline void
+rtb__shaper_forget_font(struct rtb_font_manager *fm,
+		struct rtb_texture_font *font)
+{
+	return;
+}
+
+static inline int
+rtb__shaper_init(struct rtb_font_manager *fm)
+{
+	fm->shaper = NULL;
+	return 0;
+}
+
+static inline void
+rtb__shaper_fini(struct rtb_font_manager *fm)
+{
+	return;
+}
+
+#endif
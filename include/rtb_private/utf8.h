@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <sys/types.h>
 
 #include <rutabaga/types.h>
 
@@ -140,3 +141,39 @@ u8chars(const rtb_utf8_t *string)
 
 	return ret;
 }
+
+/**
+ * bulk operations, vectorised where the target allows it.
+ * see src/text/utf8.c.
+ */
+
+/**
+ * returns the length of the run of ASCII bytes at the start of `str`.
+ * if it's equal to `nbytes`, the whole string is ASCII.
+ */
+size_t rtb__u8_ascii_prefix(const rtb_utf8_t *str, size_t nbytes);
+
+/**
+ * returns the length of the longest prefix of `str` which is valid,
+ * complete UTF-8. if it's equal to `nbytes`, the whole string is valid.
+ */
+size_t rtb__u8_valid_prefix(const rtb_utf8_t *str, size_t nbytes);
+
+/**
+ * returns the number of codepoints in the first `nbytes` of `str`.
+ * counts lead bytes, so like u8chars() it assumes valid input.
+ */
+size_t rtb__u8_count(const rtb_utf8_t *str, size_t nbytes);
+
+/**
+ * returns the byte offset of codepoint `idx` in `str`, or -1 if there
+ * are fewer than `idx + 1` codepoints in the first `nbytes`.
+ */
+ssize_t rtb__u8_offset(const rtb_utf8_t *str, size_t nbytes, size_t idx);
+
+/**
+ * decodes `nbytes` of `str` into `dst`, which must have room for
+ * `nbytes` codepoints. invalid sequences are replaced with U+FFFD.
+ * returns the number of codepoints written.
+ */
+size_t rtb__u8_decode(rtb_utf32_t *dst, const rtb_utf8_t *str, size_t nbytes);
@@ -0,0 +1,131 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <rutabaga/types.h>
+#include <rutabaga/mat4.h>
+
+#include "bsd/queue.h"
+
+/**
+ * animation
+ *
+ * an rtb_animation moves up to four floats (a float, a colour, an
+ * rtb_transform) from where they are to somewhere else over time. it
+ * belongs to whoever started it, and so do the floats; the window only
+ * keeps running animations on a list.
+ *
+ * every frame, before RTB_FRAME_START, the window steps each running
+ * animation to the frame's timestamp and marks its element dirty. it
+ * keeps asking for frames until the last one has finished, and then
+ * stops. elements that aren't animating aren't touched.
+ *
+ * an animation has to be stopped before its element or its target is
+ * freed.
+ */
+
+struct rtb_element;
+struct rtb_window;
+struct rtb_rgb_color;
+struct rtb_animation;
+
+typedef enum {
+	RTB_EASE_LINEAR = 0,
+	RTB_EASE_IN,
+	RTB_EASE_OUT,
+	RTB_EASE_IN_OUT
+} rtb_easing_t;
+
+/**
+ * what stylequads are drawn with (see rtb_stylequad.transform), for
+ * elements that animate their own position, size or rotation. `x` and
+ * `y` are an offset from where the quad would otherwise be drawn.
+ * `rotation` is in degrees, like mat4_set_rotation().
+ */
+struct rtb_transform {
+	float x, y;
+	float scale;
+	float rotation;
+};
+
+typedef void (*rtb_animation_cb_t)(struct rtb_animation *);
+
+struct rtb_animation {
+	/* public *********************************/
+
+	/* called once the animation reaches its end, but not if it's
+	 * stopped or restarted before then. may start it again. */
+	rtb_animation_cb_t finished;
+
+	/* private ********************************/
+	struct rtb_element *elem;
+	struct rtb_window *window;
+
+	float *target;
+	unsigned ncomponents;
+	float from[4];
+	float to[4];
+
+	rtb_easing_t easing;
+	uint64_t start;
+	uint64_t duration;
+
+	/* which of the window's lists we're on, if either */
+	int state;
+	TAILQ_ENTRY(rtb_animation) entry;
+};
+
+TAILQ_HEAD(rtb_animations, rtb_animation);
+
+/**
+ * starting an animation that's already running retargets it: it carries
+ * on from wherever it has got to. `elem` has to be in a window.
+ */
+void rtb_animate_float(struct rtb_animation *, struct rtb_element *elem,
+		float *target, float to,
+		unsigned duration_msec, rtb_easing_t easing);
+void rtb_animate_color(struct rtb_animation *, struct rtb_element *elem,
+		struct rtb_rgb_color *target, const struct rtb_rgb_color *to,
+		unsigned duration_msec, rtb_easing_t easing);
+void rtb_animate_transform(struct rtb_animation *, struct rtb_element *elem,
+		struct rtb_transform *target, const struct rtb_transform *to,
+		unsigned duration_msec, rtb_easing_t easing);
+
+/**
+ * leaves the target wherever the animation has got to.
+ */
+void rtb_animation_stop(struct rtb_animation *);
+int rtb_animation_is_running(const struct rtb_animation *);
+
+/**
+ * maps `t` in [0, 1] to [0, 1].
+ */
+float rtb_ease(rtb_easing_t, float t);
+
+void rtb_transform_to_mat4(const struct rtb_transform *, mat4 *);
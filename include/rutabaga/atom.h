@@ -52,12 +52,22 @@ struct rtb_atom_descriptor {
 	const char *name;
 	int ref_count;
 
-	void *dict;
-	RTB_DICT_ENTRY(rtb_atom_descriptor) dict_entry;
+	struct rtb_dict *dict;
+	uint32_t hash;
 };
 
+struct rtb_style;
+
 struct rtb_type_atom_descriptor {
 	RTB_INHERIT(rtb_atom_descriptor);
+
+	/* unique for the rutabaga's lifetime. windows use it to index
+	 * per-type tables (see style.c). */
+	unsigned id;
+
+	/* number of supertypes. `super` is ordered nearest first, so the
+	 * ancestor `n` levels above this type is `super[n - 1]`. */
+	unsigned depth;
 	struct rtb_type_atom_descriptor *super[0];
 };
 
@@ -76,5 +86,25 @@ struct rtb_type_atom_descriptor *rtb_type_ref(struct rtb_window *win,
 		struct rtb_type_atom_descriptor *super, const char *type_name);
 int rtb_type_unref(struct rtb_type_atom_descriptor *type);
 
+/**
+ * rtb_type_ref() for a type name that's a string literal. each call
+ * site gets a key of its own, and each rutabaga caches the descriptor
+ * it found for that key, so repeat calls skip hashing the name and
+ * looking it up. the cache belongs to the rutabaga, so it's covered by
+ * the same lock as everything else there.
+ */
+
+#define rtb_type_ref_static(WIN, SUPER, TYPE_NAME) __extension__ ({ \
+	static const char _rtb_type_cache_key;                           \
+	rtb_type_ref_cached(WIN, SUPER, "" TYPE_NAME "",                 \
+			&_rtb_type_cache_key);                                   \
+})
+
+struct rtb_type_atom_descriptor *rtb_type_ref_cached(struct rtb_window *win,
+		struct rtb_type_atom_descriptor *super, const char *type_name,
+		const void *key);
+
 struct rutabaga;
+void rtb_type_foreach(struct rutabaga *,
+		void (*cb)(struct rtb_type_atom_descriptor *, void *ctx), void *ctx);
 void rtb_free_all_types(struct rutabaga *);
@@ -0,0 +1,65 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+struct rtb_style_property_definition;
+
+/**
+ * properties that the toolkit asks for itself have fixed IDs. css2c
+ * (waftools/rutabaga_css/style.py) numbers them the same way, and gives
+ * any other property in a stylesheet an ID after RTB_STYLE_BUILTIN_PROPS.
+ */
+typedef enum {
+	RTB_STYLE_PROP_ID_COLOR = 0,
+	RTB_STYLE_PROP_ID_BACKGROUND_COLOR,
+	RTB_STYLE_PROP_ID_BACKGROUND_IMAGE,
+	RTB_STYLE_PROP_ID_BORDER_IMAGE,
+	RTB_STYLE_PROP_ID_BORDER_COLOR,
+	RTB_STYLE_PROP_ID_MIN_WIDTH,
+	RTB_STYLE_PROP_ID_MIN_HEIGHT,
+	RTB_STYLE_PROP_ID_FONT,
+	RTB_STYLE_PROP_ID_KNOB_ROTOR,
+
+	/* in seconds, and an rtb_easing_t. see rtb__transition_color(). */
+	RTB_STYLE_PROP_ID_TRANSITION_DURATION,
+	RTB_STYLE_PROP_ID_TRANSITION_TIMING_FUNCTION,
+
+	RTB_STYLE_BUILTIN_PROPS
+} rtb_style_prop_id_t;
+
+/**
+ * the builtin properties, resolved for an element in its current state.
+ * rebuilt by rtb_style_compute() every time the element restyles, so
+ * draw code can read it without going near the style chain. NULL where
+ * nothing sets a property.
+ *
+ * color and font are inherited: if the element's own style doesn't set
+ * them, they come from the parent's computed style.
+ */
+struct rtb_computed_style {
+	const struct rtb_style_property_definition *props[RTB_STYLE_BUILTIN_PROPS];
+};
@@ -26,20 +26,63 @@
 
 #pragma once
 
-#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
 
-#include "nedtries/nedtrie.h"
+/**
+ * open-addressing hash table with robin hood probing. callers hash keys
+ * themselves; each slot keeps the full hash and, if it's short enough,
+ * the key itself, so a lookup doesn't leave the slot array until it has
+ * found its entry.
+ *
+ * keys longer than RTB_DICT_INLINE_KEY aren't copied, and have to stay
+ * alive for as long as their entry is in the table.
+ */
+
+#define RTB_DICT_INLINE_KEY 16
+
+struct rtb_dict_slot {
+	uint32_t hash;
+
+	/* 1 + how far this entry is from the slot its hash maps to, or 0
+	 * if the slot is empty */
+	uint16_t dist;
+	uint16_t len;
+
+	union {
+		char inline_key[RTB_DICT_INLINE_KEY];
+		const char *key;
+	};
+
+	void *value;
+};
+
+struct rtb_dict {
+	struct rtb_dict_slot *slots;
+	uint32_t mask;
+	uint32_t count;
+};
+
+#define RTB_DICT_FOREACH(slot, dict)                                \
+	for ((slot) = (dict)->slots;                                    \
+			(slot) && (slot) <= &(dict)->slots[(dict)->mask];       \
+			(slot)++)                                               \
+		if ((slot)->dist)
+
+/**
+ * public API
+ */
+
+void rtb_dict_init(struct rtb_dict *);
+void rtb_dict_fini(struct rtb_dict *);
 
-#define RTB_DICT_ENTRY(type)                  \
-	struct {                                  \
-		size_t hash;                          \
-		char *key;                            \
-		NEDTRIE_ENTRY(type) trie_entry;       \
-	}
+void *rtb_dict_find(struct rtb_dict *,
+		uint32_t hash, const char *key, size_t len);
 
-#define RTB_DICT(dict_type, entry_type)       \
-	struct dict_type {                        \
-		NEDTRIE_HEAD(, entry_type);           \
-	}
+/* doesn't check for an existing entry with the same key */
+int rtb_dict_insert(struct rtb_dict *,
+		uint32_t hash, const char *key, size_t len, void *value);
 
-#define RTB_DICT_INIT(dict) NEDTRIE_INIT(dict)
+/* returns the removed entry's value, or NULL if there wasn't one */
+void *rtb_dict_remove(struct rtb_dict *,
+		uint32_t hash, const char *key, size_t len);
@@ -33,6 +33,8 @@ struct rtb_element;
 #include <rutabaga/event.h>
 #include <rutabaga/geometry.h>
 #include <rutabaga/stylequad.h>
+#include <rutabaga/computed-style.h>
+#include <rutabaga/update.h>
 
 #include "bsd/queue.h"
 #include "wwrl/vector.h"
@@ -57,6 +59,10 @@ typedef enum {
 	// element active state should stay constant even if the mouse is outside
 	// of the bounds during a drag
 	RTB_ELEM_ACTIVE_DURING_DRAG = 0x04,
+
+	// drag events targeting this element carry every cursor position
+	// that was coalesced into them (see rtb_drag_event.history)
+	RTB_ELEM_MOTION_HISTORY     = 0x08,
 } rtb_elem_flags_t;
 
 typedef enum {
@@ -96,6 +102,9 @@ typedef int (*rtb_elem_cb_reflow_t)
 typedef void (*rtb_elem_cb_child_state_t)
 	(struct rtb_element *elem, struct rtb_element *child);
 
+struct rtb_hit_grid;
+struct rtb_element_transitions;
+
 struct rtb_element_implementation {
 	/**
 	 * rtb_element_implementation.draw
@@ -189,6 +198,11 @@ struct rtb_element_implementation {
 	 *
 	 * the exceptional condition will not be handled or propagated up
 	 * the tree, but can be useful for debugging.
+	 *
+	 * overrides have to chain up to their superclass' reflow. among
+	 * other things, that's what brings the inner rect and the parent's
+	 * hit-testing grid up to date with a rect that was changed without
+	 * going through rtb_elem_set_position() or rtb_elem_set_size().
 	 */
 	rtb_elem_cb_reflow_t reflow;
 
@@ -234,11 +248,25 @@ struct rtb_element {
 
 	struct rtb_elem_children children;
 
+	/* in Hz. 0 means no limit. an element that marks itself dirty more
+	 * often than this (a meter, say) is only redrawn this often; see
+	 * rtb_surface_draw_children(). */
+	unsigned max_redraw_rate;
+
 	/* private ********************************/
 	rtb_elem_state_t state;
 	rtb_visibility_t visibility;
 	struct rtb_rect inner_rect;
 	struct rtb_stylequad stylequad;
+	struct rtb_computed_style computed;
+
+	/* allocated the first time a state change transitions one of the
+	 * stylequad's colours. see src/animation.c. */
+	struct rtb_element_transitions *transitions;
+
+	/* set while restyling because of a state change, rather than a new
+	 * style or a new place in the tree. see change_state(). */
+	int restyle_targeted;
 
 	/* assign these via the stylesheet */
 	struct rtb_size min_size;
@@ -250,9 +278,32 @@ struct rtb_element {
 	struct rtb_window  *window;
 	struct rtb_surface *surface;
 
+	/* position among siblings, increasing from the first child to the
+	 * last. not contiguous. */
+	int sibling_order;
+	unsigned nchildren;
+
+	/* see rtb_private/hit-grid.h */
+	struct rtb_hit_grid *hit_grid;
+	struct {
+		int x, y, x2, y2;
+		int state;
+	} hit_cells;
+
+	/* sorted by bucket, in registration order within each one */
 	VECTOR(handlers, struct rtb_event_handler) handlers;
+	rtb_ev_mask_t handled_events;
+
+	/* generation 0 until rtb_elem_get_handle() is called */
+	struct rtb_elem_handle handle;
+
 	TAILQ_ENTRY(rtb_element) child;
 	TAILQ_ENTRY(rtb_element) render_entry;
+
+	/* the max_redraw_rate of whatever put us on the render queue, and
+	 * the window's frame_time when we were last drawn off of it. */
+	unsigned queued_redraw_rate;
+	uint64_t last_drawn;
 };
 
 int rtb_elem_deliver_event(struct rtb_element *, const struct rtb_event *e);
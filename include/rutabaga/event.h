@@ -29,7 +29,7 @@
 #include <rutabaga/rutabaga.h>
 #include <rutabaga/types.h>
 
-#define RTB_EVENT_SYS_MASK (1 << ((sizeof(rtb_ev_type_t) * 8) - 1))
+#define RTB_EVENT_SYS_MASK (1u << ((sizeof(rtb_ev_type_t) * 8) - 1))
 #define RTB_IS_SYS_EVENT(x) (!!(x & RTB_EVENT_SYS_MASK))
 
 #define RTB_EVENT(x) RTB_UPCAST(x, rtb_event)
@@ -62,7 +62,7 @@ enum {
 
 	/**
 	 * dispatched after all drawing in a frame has occurred,
-	 * before the GL buffer swap.
+	 * before the GL buffer swap. carries an rtb_frame_end_event.
 	 */
 	RTB_FRAME_END   = SYS(4),
 
@@ -84,7 +84,13 @@ enum {
 	RTB_DRAG_MOTION = SYS(16),
 	RTB_DRAG_ENTER  = SYS(17),
 	RTB_DRAG_LEAVE  = SYS(18),
-	RTB_DRAG_DROP   = SYS(19)
+	RTB_DRAG_DROP   = SYS(19),
+
+	/**
+	 * carries an update posted from another thread. see
+	 * rutabaga/update.h.
+	 */
+	RTB_UPDATE      = SYS(20)
 };
 #undef SYS
 
@@ -147,6 +153,31 @@ struct rtb_element;
 typedef int (*rtb_event_cb_t)
 	(struct rtb_element *elem, const struct rtb_event *event, void *ctx);
 
+/**
+ * elements keep their handlers grouped into buckets by event type: one
+ * bucket for each system event, one for each low-numbered widget event,
+ * and one shared by everything else. the bitmask of buckets that have
+ * handlers in them lets dispatch skip an element in a single test.
+ */
+
+#define RTB_EVENT_BUCKETS 64
+#define RTB_EVENT_SHARED_BUCKET (RTB_EVENT_BUCKETS - 1)
+
+typedef uint64_t rtb_ev_mask_t;
+
+static inline unsigned
+rtb_event_bucket(rtb_ev_type_t type)
+{
+	if (RTB_IS_SYS_EVENT(type)) {
+		type &= ~RTB_EVENT_SYS_MASK;
+		return (type < 32) ? type : RTB_EVENT_SHARED_BUCKET;
+	}
+
+	return (type < 31) ? 32 + type : RTB_EVENT_SHARED_BUCKET;
+}
+
+#define RTB_EVENT_BIT(type) ((rtb_ev_mask_t) 1 << rtb_event_bucket(type))
+
 struct rtb_event_handler {
 	rtb_ev_type_t type;
 
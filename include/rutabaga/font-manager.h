@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <uv.h>
 #include <bsd/queue.h>
 
 #include <rutabaga/shader.h>
@@ -36,6 +38,60 @@
 #define RTB_FONT(x) RTB_UPCAST(x, rtb_font)
 #define RTB_FONT_AS(x, type) RTB_DOWNCAST(x, type, rtb_font)
 
+/**
+ * which unicode codepoints a font has glyphs for, built from its cmap.
+ *
+ * codepoints are split into 256-codepoint pages, and each page points
+ * at a 256-bit block. pages with nothing in them all share block 0, which
+ * is always empty, so a lookup is two loads and a bit test with no
+ * branches.
+ *
+ * the whole thing is one flat allocation with no pointers in it, so it
+ * can be written out as-is (rtb_font_coverage_size() bytes of it) and
+ * handed back to rtb_font_set_coverage() next time. it's stored in host
+ * byte order, and a byte-swapped magic will get it rejected.
+ */
+
+#define RTB_FONT_COVERAGE_MAGIC  0x31434252 /* "RBC1" */
+#define RTB_FONT_COVERAGE_LIMIT  0x110000
+#define RTB_FONT_COVERAGE_PAGES  (RTB_FONT_COVERAGE_LIMIT >> 8)
+
+struct rtb_font_coverage {
+	uint32_t magic;
+	uint32_t nblocks;
+
+	uint16_t pages[RTB_FONT_COVERAGE_PAGES];
+	uint32_t blocks[][8];
+};
+
+static inline int
+rtb_font_coverage_has(const struct rtb_font_coverage *cov, rtb_utf32_t c)
+{
+	const uint32_t *block;
+
+	if ((uint32_t) c >= RTB_FONT_COVERAGE_LIMIT)
+		return 0;
+
+	block = cov->blocks[cov->pages[c >> 8]];
+	return (block[(c >> 5) & 7] >> (c & 31)) & 1;
+}
+
+size_t rtb_font_coverage_size(const struct rtb_font_coverage *);
+
+/**
+ * fonts
+ */
+
+/* each of these gets its own atlas. LCD glyphs take three bytes per
+ * pixel, so anything that doesn't benefit from subpixel filtering (icon
+ * fonts, big headings) is better off grayscale. */
+typedef enum {
+	RTB_FONT_ANTIALIAS_LCD = 0,
+	RTB_FONT_ANTIALIAS_GRAYSCALE,
+
+	RTB_FONT_ANTIALIAS_COUNT
+} rtb_font_antialias_t;
+
 typedef enum {
 	RTB_FONT_EMBEDDED = 0,
 	RTB_FONT_EXTERNAL = 1
@@ -45,6 +101,22 @@ struct rtb_texture_font {
 	texture_font_t *txfont;
 	int refcount;
 
+	/* built the first time somebody asks, unless it's been handed to us
+	 * with rtb_font_set_coverage(). `built_coverage` is what we free. */
+	const struct rtb_font_coverage *coverage;
+	struct rtb_font_coverage *built_coverage;
+
+	/* how many glyphs the on-disk glyph cache has for this font, so we
+	 * know whether it needs writing back out */
+	size_t cached_glyphs;
+
+	/* hash of the face's contents, which every size of it shares.
+	 * 0 until the glyph cache first needs it. */
+	uint64_t face_hash;
+
+	/* non-NULL while glyphs are being rasterised in the background */
+	struct rtb_font_job *pending;
+
 	rtb_font_loaded_from_t loaded_from;
 	union {
 		struct {
@@ -59,10 +131,19 @@ struct rtb_texture_font {
 struct rtb_font {
 	int size;
 	float lcd_gamma;
+	rtb_font_antialias_t antialias;
 
 	struct rtb_texture_font *txfont;
 	struct rtb_font_manager *fm;
 
+	/* set by whoever owns the font when loading it failed, so that it
+	 * isn't tried again every time something asks for it. */
+	int load_failed;
+
+	/* next font to try for codepoints this one doesn't have. fallbacks
+	 * belong to the font at the head of the chain. */
+	struct rtb_font *fallback;
+
 	TAILQ_ENTRY(rtb_font) manager_entry;
 };
 
@@ -71,29 +152,67 @@ struct rtb_external_font {
 	char *path;
 };
 
+/**
+ * fragment shader variants for text. gamma is baked into the atlas, so
+ * only subpixel-shifted LCD text needs more than a single texture fetch.
+ */
+typedef enum {
+	RTB_TEXT_SHADER_GRAYSCALE = 0,
+	RTB_TEXT_SHADER_LCD,
+	RTB_TEXT_SHADER_LCD_SUBPIXEL,
+
+	RTB_TEXT_SHADER_COUNT
+} rtb_text_shader_t;
+
 struct rtb_font_manager {
 	struct rtb_font_shader {
 		RTB_INHERIT(rtb_shader);
 
 		GLint atlas_pixel;
-		GLint gamma;
-	} shader;
+	} shaders[RTB_TEXT_SHADER_COUNT];
+
+	/* created the first time a font asks for one. without FreeType LCD
+	 * support, LCD fonts share the grayscale atlas. */
+	texture_atlas_t *atlases[RTB_FONT_ANTIALIAS_COUNT];
+	int lcd_supported;
 
-	texture_atlas_t *atlas;
+	struct {
+		int x, y;
+	} dpi;
 
 	const rtb_utf32_t *cache_glyphs;
 
+	/* background rasterisation goes through this loop's threadpool. if
+	 * it's NULL, everything is rasterised synchronously. */
+	uv_loop_t *loop;
+	LIST_HEAD(pending_font_jobs, rtb_font_job) pending_jobs;
+
+	/* NULL unless built with HarfBuzz */
+	struct rtb_shaper *shaper;
+
 	TAILQ_HEAD(managed_fonts, rtb_font) managed_fonts;
 };
 
 int rtb_font_manager_load_embedded_font(struct rtb_font_manager *fm,
 		struct rtb_font *font, int pt_size, const void *base, size_t size);
 void rtb_font_manager_free_embedded_font(struct rtb_font *font);
+int rtb_font_manager_prefetch_embedded_font(struct rtb_font_manager *fm,
+		struct rtb_font *font, int pt_size, const void *base, size_t size);
+void rtb_font_ready(const struct rtb_font *font);
 
 int rtb_font_manager_load_external_font(struct rtb_font_manager *fm,
 		struct rtb_external_font *font, int pt_size, const char *path);
 void rtb_font_manager_free_external_font(struct rtb_external_font *font);
 
+int rtb_font_manager_add_embedded_fallback(struct rtb_font_manager *fm,
+		struct rtb_font *font, const void *base, size_t size);
+
+const struct rtb_font *rtb_font_for_codepoint(const struct rtb_font *,
+		rtb_utf32_t);
+
+const struct rtb_font_coverage *rtb_font_get_coverage(const struct rtb_font *);
+int rtb_font_set_coverage(struct rtb_font *, const void *buf, size_t size);
+
 void rtb_font_manager_set_dpi(struct rtb_font_manager *, int dpi_x, int dpi_y);
 
 int rtb_font_manager_init(struct rtb_font_manager *, int dpi_x, int dpi_y);
@@ -0,0 +1,122 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * frame pacing statistics
+ *
+ * every frame that draws is timed as it goes, and kept in a ring of the
+ * last RTB_FRAME_STATS_HISTORY frames. the window's `frame_stats` also
+ * keeps totals over every frame since it opened (or since the last
+ * rtb_frame_stats_reset()). all of it needs the window lock.
+ */
+
+#define RTB_FRAME_STATS_HISTORY 128
+
+/* frame times (start to swap) are bucketed RTB_FRAME_STATS_BUCKET_MSEC
+ * wide in the histogram. the last bucket takes anything longer. */
+#define RTB_FRAME_STATS_BUCKETS 32
+#define RTB_FRAME_STATS_BUCKET_MSEC 1
+
+typedef enum {
+	/* rtb_window_draw() was called */
+	RTB_FRAME_PHASE_START = 0,
+
+	/* updates from other threads, rtb_window_call_next_frame() calls
+	 * and animations have run */
+	RTB_FRAME_PHASE_EVENTS,
+
+	/* RTB_FRAME_START handlers, and whatever reflowing they caused,
+	 * are done */
+	RTB_FRAME_PHASE_LAYOUT,
+
+	/* everything has been drawn, overlays included */
+	RTB_FRAME_PHASE_DRAW,
+
+	/* the buffers have been swapped, or handed to the render thread */
+	RTB_FRAME_PHASE_SWAP,
+
+	/* the frame is on screen, as near as the platform can tell. stays
+	 * 0 on platforms that can't. */
+	RTB_FRAME_PHASE_PRESENT,
+
+	RTB_FRAME_PHASE_COUNT
+} rtb_frame_phase_t;
+
+struct rtb_frame_timing {
+	uint64_t serial;
+
+	/* uv_hrtime() as the frame reached each phase, or 0 if it hasn't
+	 * (yet). */
+	uint64_t at[RTB_FRAME_PHASE_COUNT];
+
+	/* CPU time the drawing thread spent between START and SWAP, in
+	 * nanoseconds. 0 where the platform doesn't track it per thread. */
+	uint64_t cpu_time;
+
+	unsigned restyled;
+	int missed_deadline;
+};
+
+struct rtb_frame_stats {
+	/* public *********************************/
+
+	/* frames taking longer than this from start to swap have missed
+	 * their deadline. in nanoseconds, defaults to 1/60th of a second. */
+	uint64_t deadline;
+
+	/* read-only */
+	uint64_t frames;
+	uint64_t missed_deadlines;
+	unsigned histogram[RTB_FRAME_STATS_BUCKETS];
+
+	/* private ********************************/
+	struct rtb_frame_timing current;
+	uint64_t cpu_start;
+
+	struct rtb_frame_timing history[RTB_FRAME_STATS_HISTORY];
+};
+
+/**
+ * copies out the frame `frames_ago` frames before the last one drawn
+ * (0 for the last one itself). returns -1 if it's no longer, or was
+ * never, in the history.
+ */
+int rtb_frame_stats_get_timing(const struct rtb_frame_stats *,
+		unsigned frames_ago, struct rtb_frame_timing *timing);
+
+/**
+ * the frame time (start to swap) that `fraction` of the frames in the
+ * histogram came in under, in milliseconds. 0.99 gives the 99th
+ * percentile. only as precise as RTB_FRAME_STATS_BUCKET_MSEC.
+ */
+unsigned rtb_frame_stats_percentile(const struct rtb_frame_stats *,
+		float fraction);
+
+void rtb_frame_stats_reset(struct rtb_frame_stats *);
@@ -30,6 +30,8 @@
 #include <rutabaga/event.h>
 #include <rutabaga/keyboard.h>
 
+#include "wwrl/vector.h"
+
 #define RTB_EVENT_MOUSE(x) RTB_UPCAST(x, rtb_event_mouse)
 #define RTB_EVENT_DRAG(x) RTB_UPCAST(x, rtb_event_drag)
 
@@ -107,6 +109,13 @@ struct rtb_drag_event {
 		float x;
 		float y;
 	} delta;
+
+	/* every cursor position that was folded into this event, oldest
+	 * first and ending with `cursor`. only filled in when the drag's
+	 * target has the RTB_ELEM_MOTION_HISTORY flag set, and only on
+	 * platforms that coalesce motion. otherwise NULL. */
+	const struct rtb_point *history;
+	size_t history_size;
 };
 
 /**
@@ -132,6 +141,10 @@ struct rtb_mouse {
 
 	rtb_mouse_button_mask_t buttons_down;
 	rtb_mouse_cursor_t current_cursor;
+
+	/* motion queued up by the platform and not yet dispatched. see
+	 * rtb__platform_mouse_motion_queue(). */
+	VECTOR(rtb_mouse_motion_history, struct rtb_point) motion_history;
 };
 
 /**
@@ -45,6 +45,15 @@ void rtb__platform_mouse_release(struct rtb_window *,
 		int buttons, struct rtb_point);
 void rtb__platform_mouse_motion(struct rtb_window *, struct rtb_point);
 
+/**
+ * platforms that receive motion faster than it's worth dispatching can
+ * queue it up instead, and flush the queue once they've drained their
+ * event source or before any other event. only the last position is
+ * dispatched, the rest are handed to elements that ask for them.
+ */
+void rtb__platform_mouse_motion_queue(struct rtb_window *, struct rtb_point);
+void rtb__platform_mouse_motion_flush(struct rtb_window *);
+
 void rtb__platform_mouse_wheel(struct rtb_window *, struct rtb_point,
 		float delta);
 
@@ -63,6 +72,16 @@ void rtb__platform_mouse_leave_window(struct rtb_window *, struct rtb_point);
  */
 int64_t rtb_mouse_double_click_interval(struct rtb_window *);
 
+/**
+ * asks for rtb_window_draw() to be called soon, at the next vblank if
+ * the platform can tell when that is. platforms that don't draw on
+ * demand can ignore this.
+ *
+ * may be called from any thread. threads other than the event loop's
+ * don't need the window lock, and this won't block them.
+ */
+void rtb__platform_request_frame(struct rtb_window *);
+
 void rtb__platform_set_cursor(struct rtb_window *, struct rtb_mouse *,
 		rtb_mouse_cursor_t cursor);
 void rtb_mouse_pointer_warp(struct rtb_window *, struct rtb_point);
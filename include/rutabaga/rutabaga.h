@@ -47,7 +47,16 @@ struct rutabaga {
 
 	/* private ********************************/
 	struct {
-		RTB_DICT(rtb_atom_dict, rtb_atom_descriptor) type;
+		struct rtb_dict type;
+
+		/* bumped whenever a type is created. new types take the
+		 * old value as their id. */
+		unsigned generation;
+
+		/* see rtb_type_ref_cached() */
+		struct rtb_type_cache_slot *cache;
+		unsigned cache_mask;
+		unsigned cache_count;
 	} atoms;
 
 	/* XXX: need to be able to handle several of these */
@@ -32,6 +32,8 @@
 #include <rutabaga/element.h>
 #include <rutabaga/asset.h>
 #include <rutabaga/atom.h>
+#include <rutabaga/animation.h>
+#include <rutabaga/computed-style.h>
 
 typedef enum {
 	RTB_STYLE_PROP_COLOR = 0,
@@ -66,7 +68,13 @@ struct rtb_style_font_face {
 
 struct rtb_style_font_definition {
 	const struct rtb_style_font_face *face;
+
+	/* NULL-terminated, tried in order for codepoints `face` lacks.
+	 * may be NULL. */
+	const struct rtb_style_font_face *const *fallbacks;
+
 	float lcd_gamma;
+	rtb_font_antialias_t antialias;
 	int size;
 
 	/* private ********************************/
@@ -111,6 +119,12 @@ struct rtb_style {
 	const char *for_type;
 	const struct rtb_style_property_definition *properties[RTB_DRAW_STATE_COUNT];
 
+	/* indexed by property ID: 1 + the property's position in
+	 * `properties`, or 0 if the state doesn't set it. generated by
+	 * css2c. styles without it (NULL) are searched by name. */
+	size_t nprops;
+	const uint8_t *prop_index[RTB_DRAW_STATE_COUNT];
+
 	/* private ********************************/
 	struct rtb_style *inherit_from;
 	struct rtb_type_atom_descriptor *resolved_type;
@@ -119,12 +133,29 @@ struct rtb_style {
 struct rtb_style_data {
 	struct rtb_style *style;
 	size_t nfonts;
+
+	/* NULL-terminated, indexed by property ID */
+	const char *const *prop_names;
 };
 
 /**
  * public API
  */
 
+const struct rtb_style_property_definition *rtb_style_query_prop_by_id(
+		struct rtb_element *elem, rtb_style_prop_id_t id,
+		rtb_style_prop_type_t type, int should_return_fallback);
+const struct rtb_style_property_definition *rtb_style_query_prop_in_tree_by_id(
+		struct rtb_element *leaf, rtb_style_prop_id_t id,
+		rtb_style_prop_type_t type, int should_return_fallback);
+
+int rtb_style_prop_id(struct rtb_window *, const char *property_name);
+
+void rtb_style_compute(struct rtb_element *elem);
+const struct rtb_style_property_definition *rtb_style_computed_prop(
+		const struct rtb_element *elem, rtb_style_prop_id_t id,
+		int should_return_fallback);
+
 const struct rtb_style_property_definition *rtb_style_query_prop(
 		struct rtb_element *elem, const char *property_name,
 		rtb_style_prop_type_t type, int should_return_fallback);
@@ -144,5 +175,6 @@ int rtb_style_resolve_list(struct rtb_window *,
 
 struct rtb_font *rtb_style_get_font_for_def(struct rtb_window *,
 		const struct rtb_style_font_definition *);
+void rtb_style_prefetch_fonts(struct rtb_element *root);
 
 struct rtb_style_data rtb_style_get_defaults(void);
@@ -45,9 +45,17 @@ typedef enum {
 		| RTB_STYLEQUAD_DRAW_BORDER_COLOR,
 } rtb_stylequad_draw_mode_t;
 
+struct rtb_transform;
+
 struct rtb_stylequad {
 	struct rtb_point offset;
 
+	/* if set, rtb_stylequad_draw_on_element() moves, scales and rotates
+	 * the quad by this. point it at something rtb_animate_transform()
+	 * is animating to animate the quad. it only changes how the quad
+	 * is drawn, not the element's rect or hit-testing. */
+	const struct rtb_transform *transform;
+
 	GLuint vertices;
 
 	struct {
@@ -34,9 +34,111 @@
 #include <rutabaga/render.h>
 
 #include "freetype-gl/vertex-buffer.h"
+#include "wwrl/vector.h"
+
+typedef enum {
+	/* only break lines on '\n', let them run past the width */
+	RTB_TEXT_OVERFLOW_VISIBLE = 0,
+
+	/* break lines between words (or inside them, if a single word
+	 * doesn't fit) */
+	RTB_TEXT_OVERFLOW_WRAP,
+
+	/* cut overlong lines and mark the cut with an ellipsis */
+	RTB_TEXT_OVERFLOW_ELLIPSIS_END,
+	RTB_TEXT_OVERFLOW_ELLIPSIS_MIDDLE
+} rtb_text_overflow_t;
+
+/**
+ * cached per-glyph metrics, in window coordinates. ink extents are
+ * relative to the pen position and the baseline.
+ *
+ * without shaping there's one of these per codepoint. with it, a cluster
+ * of codepoints can turn into any number of glyphs, and `charcode` is a
+ * glyph index OR'd with TEXTURE_FONT_GLYPH_INDEX.
+ */
+struct rtb_text_glyph {
+	/* the font in the fallback chain that this glyph comes from */
+	texture_font_t *font;
+	int32_t charcode;
+
+	/* index of the (first) codepoint this glyph came from */
+	unsigned cluster;
+
+	float kerning;
+	float advance;
+	float x0, y0, x1, y1;
+};
+
+/**
+ * a run of non-space glyphs [start, end), followed by the whitespace
+ * [end, next). `width` doesn't include the kerning against whatever comes
+ * before `start`, since that depends on what ends up next to it.
+ */
+struct rtb_text_word {
+	unsigned start, end, next;
+	float width, space;
+	int hard_break;
+};
+
+/**
+ * glyphs [start, end) are drawn, except that if `cut < resume`, the
+ * range [cut, resume) is replaced with an ellipsis.
+ */
+struct rtb_text_line {
+	unsigned start, end;
+
+	/* if `ellipsized`, the ellipsis is drawn in place of the glyphs
+	 * from `cut` up to `resume`, which may be none of them. */
+	unsigned cut, resume;
+	int ellipsized;
+
+	float width;
+};
 
 struct rtb_text_object {
 	GLfloat w, h;
+	unsigned lines;
+
+	/* run text through the shaper, if we were built with one. on by
+	 * default. turn it off if glyphs need to line up with codepoints. */
+	int shaping;
+
+	/* ink bounds of the laid out glyphs */
+	struct rtb_rect bbox;
+
+	/* private ********************************/
+
+	/* scratch space for decoding, reused between updates */
+	VECTOR(rtb_text_codepoints, rtb_utf32_t) codepoints;
+
+	/* break opportunities and advances, built by
+	 * rtb_text_object_update() and reused by rtb_text_object_constrain() */
+	VECTOR(rtb_text_glyphs, struct rtb_text_glyph) glyphs;
+	VECTOR(rtb_text_words, struct rtb_text_word) words;
+	VECTOR(rtb_text_lines, struct rtb_text_line) line_info;
+
+	struct {
+		const struct rtb_font *font;
+		rtb_utf32_t codepoint;
+		int repeat;
+
+		struct rtb_text_glyph metrics;
+	} ellipsis;
+
+	float max_width;
+	rtb_text_overflow_t overflow;
+
+	struct rtb_point scale;
+	float line_height;
+
+	/* set by rtb_text_object_update(), geometry is generated on the
+	 * next render or glyph query. */
+	int geometry_dirty;
+
+	/* whether any glyph quad landed between device pixels, which is
+	 * the only case that needs the subpixel LCD shader */
+	int subpixel_shifted;
 
 	vertex_buffer_t *vertices;
 	struct rtb_font_manager *fm;
@@ -47,6 +149,11 @@ int rtb_text_object_get_glyph_rect(struct rtb_text_object *, int idx,
 		struct rtb_rect *rect);
 int rtb_text_object_count_glyphs(struct rtb_text_object *);
 
+/**
+ * measures `text` and fills in `w`, `h`, `lines` and `bbox`. this only
+ * needs glyph metrics, so it's cheap enough to call during size
+ * negotiation. vertex data isn't generated until the text is drawn.
+ */
 int rtb_text_object_update(struct rtb_text_object *,
 		struct rtb_font *rfont, struct rtb_window *,
 		const rtb_utf8_t *text, float line_height_multiplier);
@@ -54,5 +161,16 @@ void rtb_text_object_render(struct rtb_text_object *,
 		struct rtb_render_context *ctx, float x, float y,
 		const struct rtb_rgb_color *color);
 
+/**
+ * lays the text out again within `max_width` (or unconstrained, if
+ * `max_width` is <= 0), without looking up any glyphs. the constraint is
+ * kept for subsequent calls to rtb_text_object_update().
+ *
+ * note that ellipses are drawn as glyphs of their own, so glyph indices
+ * stop lining up with codepoints once a line has been cut.
+ */
+void rtb_text_object_constrain(struct rtb_text_object *,
+		float max_width, rtb_text_overflow_t overflow);
+
 struct rtb_text_object *rtb_text_object_new(struct rtb_font_manager *fm);
 void rtb_text_object_free(struct rtb_text_object *self);
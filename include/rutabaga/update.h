@@ -0,0 +1,117 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <rutabaga/types.h>
+#include <rutabaga/event.h>
+
+/**
+ * updating elements from other threads
+ *
+ * a thread that must never block (an audio thread, say) can't take the
+ * window lock. instead, it gets an rtb_update_queue of its own and posts
+ * updates to elements by handle. posting never blocks or allocates.
+ *
+ * the window drains its queues right before RTB_FRAME_START and delivers
+ * an RTB_UPDATE event to each target, carrying only the latest value of
+ * each kind posted to it since the last frame.
+ */
+
+/**
+ * handles stay valid while their element is in a window. once it's
+ * removed or freed, its handle goes stale and updates posted to it are
+ * dropped.
+ */
+struct rtb_elem_handle {
+	uint32_t index;
+	uint32_t generation;
+};
+
+union rtb_update_value {
+	float f;
+	double d;
+	int32_t i;
+	void *p;
+};
+
+enum {
+	/* value elements pass value.f to rtb_value_element_set_value(). */
+	RTB_UPDATE_VALUE = 0,
+
+	/* application-defined kinds start here. */
+	RTB_UPDATE_USER = 0x100
+};
+
+struct rtb_update {
+	struct rtb_elem_handle target;
+	unsigned kind;
+	union rtb_update_value value;
+};
+
+struct rtb_update_event {
+	RTB_INHERIT(rtb_event);
+
+	unsigned kind;
+	union rtb_update_value value;
+};
+
+struct rtb_update_queue;
+
+/**
+ * these need the window lock.
+ */
+
+struct rtb_elem_handle rtb_elem_get_handle(struct rtb_element *);
+struct rtb_element *rtb_elem_from_handle(struct rtb_window *,
+		struct rtb_elem_handle);
+
+/**
+ * each queue takes updates from one thread at a time. `capacity` is
+ * rounded up to a power of two. queues still open when the window closes
+ * are freed along with it.
+ */
+struct rtb_update_queue *rtb_update_queue_new(struct rtb_window *,
+		unsigned capacity);
+void rtb_update_queue_free(struct rtb_update_queue *);
+
+/**
+ * these don't, and are wait-free.
+ *
+ * returns -1 if the queue is full, in which case the update is dropped.
+ */
+int rtb_update_post(struct rtb_update_queue *, struct rtb_elem_handle target,
+		unsigned kind, union rtb_update_value value);
+
+static inline int
+rtb_update_post_value(struct rtb_update_queue *queue,
+		struct rtb_elem_handle target, float value)
+{
+	return rtb_update_post(queue, target, RTB_UPDATE_VALUE,
+			(union rtb_update_value) {.f = value});
+}
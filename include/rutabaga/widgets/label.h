@@ -37,6 +37,13 @@ struct rtb_label {
 	float line_height_multiplier;
 	const char *cls;
 
+	/* what to do when the text doesn't fit in the width the label is
+	 * offered during layout. */
+	rtb_text_overflow_t overflow;
+
+	/* see rtb_text_object.shaping */
+	int shaping;
+
 	/* private ********************************/
 	rtb_utf8_t *text;
 	struct rtb_font *font;
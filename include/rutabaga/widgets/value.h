@@ -43,6 +43,10 @@ typedef enum {
 struct rtb_value_change_event {
 	RTB_INHERIT(rtb_event);
 	float value;
+
+	/* how many earlier changes were folded into this one. always 0
+	 * unless the element has coalesce_changes set. */
+	unsigned merged;
 };
 
 struct rtb_value_state_event {
@@ -74,13 +78,27 @@ struct rtb_value_element {
 
 	unsigned deny_drag_start_mod_mask;
 
+	/* while the value is being dragged or wheeled, send at most one
+	 * RTB_VALUE_CHANGE per frame, and always one for the final value
+	 * when editing ends. */
+	int coalesce_changes;
+
 	/* read-only ******************************/
 	float value;
 
+	struct {
+		unsigned delivered;
+		unsigned merged;
+	} change_stats;
+
 	/* private ********************************/
 	rtb_value_element_state_t ve_state;
 	float normalised_value;
 
+	int change_pending;
+	rtb_ev_source_t pending_source;
+	unsigned pending_merged;
+
 	void (*set_value_hook)(struct rtb_element *,
 		const struct rtb_event *derived_from_event);
 };
@@ -35,6 +35,8 @@
 #include <rutabaga/mouse.h>
 #include <rutabaga/event.h>
 #include <rutabaga/font-manager.h>
+#include <rutabaga/animation.h>
+#include <rutabaga/frame-stats.h>
 
 #define RTB_WINDOW(x) RTB_UPCAST(x, rtb_window)
 #define RTB_WINDOW_AS(x, type) RTB_DOWNCAST(x, type, rtb_window)
@@ -46,6 +48,18 @@ struct rtb_window_event {
 	struct rtb_window *window;
 };
 
+/**
+ * RTB_FRAME_END comes before the swap, so `timing` (the frame being
+ * drawn) only goes as far as RTB_FRAME_PHASE_LAYOUT. the frames before
+ * it are in `stats`.
+ */
+struct rtb_frame_end_event {
+	RTB_INHERIT(rtb_window_event);
+
+	const struct rtb_frame_timing *timing;
+	const struct rtb_frame_stats *stats;
+};
+
 struct rtb_window_local_storage {
 	struct {
 		struct rtb_shader dfault;
@@ -67,6 +81,13 @@ struct rtb_window_local_storage {
 	} ibo;
 };
 
+typedef void (*rtb_frame_cb_t)(struct rtb_element *);
+
+struct rtb_frame_call {
+	struct rtb_elem_handle elem;
+	rtb_frame_cb_t cb;
+};
+
 struct rtb_window {
 	RTB_INHERIT(rtb_surface);
 	struct rtb_font_manager font_manager;
@@ -76,6 +97,14 @@ struct rtb_window {
 
 	struct rtb_style *style_list;
 	struct rtb_font *style_fonts;
+	const char *const *style_prop_names;
+
+	/* how many elements were restyled in the run-up to the last frame
+	 * that was drawn */
+	unsigned restyled_last_frame;
+
+	/* see rutabaga/frame-stats.h */
+	struct rtb_frame_stats frame_stats;
 
 	/* private ********************************/
 	int finished_initialising;
@@ -83,6 +112,27 @@ struct rtb_window {
 	int dpi_changed;
 	int dirty;
 
+	/* restyles since the last frame */
+	unsigned restyled;
+
+	/* what rtb_style_resolve_list() last resolved, and how many types
+	 * there had been by then. see style.c. */
+	const struct rtb_style *resolved_style_list;
+	unsigned resolved_type_generation;
+	int unresolved_styles;
+
+	/* the style each type gets from `resolved_style_list`, indexed by
+	 * type id. an entry only counts if its stamp is current. */
+	struct rtb_type_style {
+		unsigned stamp;
+		struct rtb_style *style;
+	} *type_styles;
+	unsigned ntype_styles;
+	unsigned type_style_stamp;
+
+	/* uv_hrtime() when the current (or last) frame started */
+	uint64_t frame_time;
+
 	struct {
 		int x;
 		int y;
@@ -100,6 +150,20 @@ struct rtb_window {
 	struct rtb_mouse mouse;
 	struct rtb_element *focus;
 
+	/* see src/update.c */
+	VECTOR(rtb_elem_handle_slots, struct rtb__elem_handle_slot) handle_slots;
+	uint32_t free_handle;
+
+	TAILQ_HEAD(rtb_update_queues, rtb_update_queue) update_queues;
+	VECTOR(rtb_pending_updates, struct rtb__pending_update) pending_updates;
+	int updates_need_wakeup;
+
+	VECTOR(rtb_frame_calls, struct rtb_frame_call) frame_calls;
+
+	/* see src/animation.c */
+	struct rtb_animations animations;
+	struct rtb_animations finishing_animations;
+
 	int mouse_in_overlay;
 	struct rtb_surface overlay_surface;
 };
@@ -113,6 +177,21 @@ struct rtb_window {
  */
 int rtb_window_draw(struct rtb_window *, int force_redraw);
 
+/**
+ * windows only draw when something has changed. anything that needs a
+ * frame without marking an element dirty (for example, something
+ * animating from an RTB_FRAME_START handler) has to ask for each one.
+ */
+void rtb_window_request_frame(struct rtb_window *);
+
+/**
+ * calls `cb` at the start of the next frame, before RTB_FRAME_START is
+ * dispatched, and asks for that frame. if `elem` has left the window by
+ * then, the call is dropped.
+ */
+void rtb_window_call_next_frame(struct rtb_window *, struct rtb_element *,
+		rtb_frame_cb_t cb);
+
 void rtb_window_focus_element(struct rtb_window *,
 		struct rtb_element *focused);
 
@@ -136,7 +215,12 @@ void rtb_window_remove_overlay(struct rtb_window *, struct rtb_element *);
  */
 
 typedef enum {
-	RTB_WINDOW_OPEN_AS_IF_PARENTED = 1
+	RTB_WINDOW_OPEN_AS_IF_PARENTED = 1,
+
+	/* present frames from a separate thread so that waiting for vsync
+	 * doesn't hold up the event loop. only x11 does this for now, the
+	 * flag is ignored elsewhere. */
+	RTB_WINDOW_OPEN_THREADED_RENDERING = 2
 } rtb_window_open_option_flags_t;
 
 struct rtb_window_open_options {
@@ -0,0 +1,358 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <uv.h>
+
+#include <rutabaga/rutabaga.h>
+#include <rutabaga/window.h>
+#include <rutabaga/element.h>
+#include <rutabaga/platform.h>
+#include <rutabaga/style.h>
+#include <rutabaga/animation.h>
+
+#include "rtb_private/animation.h"
+
+#define NSEC_PER_MSEC 1000000ull
+
+/* the state of an animation on either list is the list it's on */
+#define IDLE      0
+#define RUNNING   1
+#define FINISHING 2
+
+/* used when a style sets transition-duration but no timing function */
+#define DEFAULT_TRANSITION_EASING RTB_EASE_OUT
+
+struct rtb_color_transition {
+	struct rtb_animation anim;
+
+	struct rtb_rgb_color current;
+	const struct rtb_rgb_color *to;
+	const struct rtb_rgb_color **dest;
+};
+
+struct rtb_element_transitions {
+	struct rtb_color_transition color[RTB__TRANSITION_COUNT];
+};
+
+/**
+ * easing
+ */
+
+float
+rtb_ease(rtb_easing_t easing, float t)
+{
+	float u;
+
+	switch (easing) {
+	case RTB_EASE_LINEAR:
+		return t;
+
+	case RTB_EASE_IN:
+		return t * t * t;
+
+	case RTB_EASE_OUT:
+		u = 1.f - t;
+		return 1.f - (u * u * u);
+
+	case RTB_EASE_IN_OUT:
+		if (t < .5f)
+			return 4.f * t * t * t;
+
+		u = 2.f - (2.f * t);
+		return 1.f - (u * u * u * .5f);
+	}
+
+	return t;
+}
+
+void
+rtb_transform_to_mat4(const struct rtb_transform *self, mat4 *m)
+{
+	/* stylequads are centered on their origin, so this scales and
+	 * rotates around the middle of the element. */
+	mat4_set_scaling(m, self->scale, self->scale, 1.f);
+	mat4_rotate(m, self->rotation, 0.f, 0.f, 1.f);
+	mat4_translate(m, self->x, self->y, 0.f);
+}
+
+/**
+ * running animations
+ */
+
+static void
+step(struct rtb_animation *self, float t)
+{
+	unsigned i;
+
+	for (i = 0; i < self->ncomponents; i++)
+		self->target[i] = self->from[i]
+			+ ((self->to[i] - self->from[i]) * t);
+}
+
+void
+rtb__animation_tick(struct rtb_window *win)
+{
+	struct rtb_animation *anim, *next;
+	uint64_t now, elapsed;
+
+	if (TAILQ_EMPTY(&win->animations))
+		return;
+
+	/* every animation sees the same time, so things started together
+	 * stay together. */
+	now = win->frame_time;
+
+	TAILQ_FOREACH_SAFE(anim, &win->animations, entry, next) {
+		/* started partway through this frame */
+		elapsed = (now > anim->start) ? now - anim->start : 0;
+
+		if (elapsed >= anim->duration) {
+			step(anim, 1.f);
+
+			TAILQ_REMOVE(&win->animations, anim, entry);
+			TAILQ_INSERT_TAIL(&win->finishing_animations, anim, entry);
+			anim->state = FINISHING;
+		} else
+			step(anim, rtb_ease(anim->easing,
+						(float) elapsed / (float) anim->duration));
+
+		rtb_elem_mark_dirty(anim->elem);
+	}
+
+	/* `finished` callbacks can start and stop whatever they like, so
+	 * they run once we're done walking the list. */
+	while ((anim = TAILQ_FIRST(&win->finishing_animations))) {
+		TAILQ_REMOVE(&win->finishing_animations, anim, entry);
+		anim->state = IDLE;
+
+		if (anim->finished)
+			anim->finished(anim);
+	}
+
+	if (!TAILQ_EMPTY(&win->animations))
+		rtb__platform_request_frame(win);
+}
+
+/**
+ * public API
+ */
+
+static void
+start(struct rtb_animation *self, struct rtb_element *elem,
+		float *target, const float *to, unsigned ncomponents,
+		unsigned duration_msec, rtb_easing_t easing)
+{
+	struct rtb_window *win = elem->window;
+
+	assert(win);
+	assert(ncomponents <= 4);
+
+	rtb_animation_stop(self);
+
+	self->elem   = elem;
+	self->window = win;
+
+	self->target = target;
+	self->ncomponents = ncomponents;
+	memcpy(self->from, target, ncomponents * sizeof(*target));
+	memcpy(self->to, to, ncomponents * sizeof(*to));
+
+	self->easing   = easing;
+	self->start    = uv_hrtime();
+	self->duration = duration_msec * NSEC_PER_MSEC;
+
+	TAILQ_INSERT_TAIL(&win->animations, self, entry);
+	self->state = RUNNING;
+
+	rtb__platform_request_frame(win);
+}
+
+void
+rtb_animate_float(struct rtb_animation *self, struct rtb_element *elem,
+		float *target, float to,
+		unsigned duration_msec, rtb_easing_t easing)
+{
+	start(self, elem, target, &to, 1, duration_msec, easing);
+}
+
+void
+rtb_animate_color(struct rtb_animation *self, struct rtb_element *elem,
+		struct rtb_rgb_color *target, const struct rtb_rgb_color *to,
+		unsigned duration_msec, rtb_easing_t easing)
+{
+	const float to_components[4] = {to->r, to->g, to->b, to->a};
+
+	start(self, elem, &target->r, to_components, 4, duration_msec, easing);
+}
+
+void
+rtb_animate_transform(struct rtb_animation *self, struct rtb_element *elem,
+		struct rtb_transform *target, const struct rtb_transform *to,
+		unsigned duration_msec, rtb_easing_t easing)
+{
+	const float to_components[4] =
+		{to->x, to->y, to->scale, to->rotation};
+
+	start(self, elem, &target->x, to_components, 4, duration_msec, easing);
+}
+
+void
+rtb_animation_stop(struct rtb_animation *self)
+{
+	switch (self->state) {
+	case RUNNING:
+		TAILQ_REMOVE(&self->window->animations, self, entry);
+		break;
+
+	case FINISHING:
+		TAILQ_REMOVE(&self->window->finishing_animations, self, entry);
+		break;
+	}
+
+	self->state = IDLE;
+}
+
+int
+rtb_animation_is_running(const struct rtb_animation *self)
+{
+	return self->state == RUNNING;
+}
+
+/**
+ * style transitions
+ */
+
+static void
+color_transition_finished(struct rtb_animation *anim)
+{
+	struct rtb_color_transition *tr =
+		RTB_CONTAINER_OF(anim, struct rtb_color_transition, anim);
+
+	/* point back at the stylesheet's colour, so that the next restyle
+	 * can tell whether anything changed. */
+	*tr->dest = tr->to;
+}
+
+static int
+transition_params(struct rtb_element *elem,
+		unsigned *duration_msec, rtb_easing_t *easing)
+{
+	const struct rtb_style_property_definition *prop;
+
+	/* only state changes transition. a new stylesheet, or a new place
+	 * in the tree, takes effect straight away. */
+	if (!elem->restyle_targeted)
+		return 0;
+
+	prop = rtb_style_computed_prop(elem,
+			RTB_STYLE_PROP_ID_TRANSITION_DURATION, 0);
+	if (!prop || prop->flt <= 0.f)
+		return 0;
+
+	*duration_msec = (unsigned) (prop->flt * 1000.f);
+
+	prop = rtb_style_computed_prop(elem,
+			RTB_STYLE_PROP_ID_TRANSITION_TIMING_FUNCTION, 0);
+	*easing = prop ? (rtb_easing_t) prop->i : DEFAULT_TRANSITION_EASING;
+
+	return 1;
+}
+
+int
+rtb__transition_color(struct rtb_element *elem, rtb__transition_slot_t slot,
+		const struct rtb_rgb_color **dest, const struct rtb_rgb_color *to)
+{
+	struct rtb_color_transition *tr;
+	unsigned duration_msec;
+	rtb_easing_t easing;
+
+	tr = elem->transitions ? &elem->transitions->color[slot] : NULL;
+
+	if (tr && *dest == &tr->current) {
+		if (tr->to == to)
+			return -1;
+	} else if (*dest == to)
+		return -1;
+
+	if (!*dest || !transition_params(elem, &duration_msec, &easing)) {
+		if (tr)
+			rtb_animation_stop(&tr->anim);
+
+		*dest = to;
+		return 0;
+	}
+
+	if (!tr) {
+		if (!(elem->transitions = calloc(1, sizeof(*elem->transitions))))
+			goto err_alloc;
+
+		tr = &elem->transitions->color[slot];
+	}
+
+	/* starting from rest, rather than from partway through a
+	 * transition that's being interrupted. */
+	if (*dest != &tr->current)
+		tr->current = **dest;
+
+	tr->to   = to;
+	tr->dest = dest;
+	tr->anim.finished = color_transition_finished;
+
+	*dest = &tr->current;
+	rtb_animate_color(&tr->anim, elem, &tr->current, to,
+			duration_msec, easing);
+
+	return 0;
+
+err_alloc:
+	*dest = to;
+	return 0;
+}
+
+void
+rtb__transitions_free(struct rtb_element *elem)
+{
+	struct rtb_color_transition *tr;
+	int i;
+
+	if (!elem->transitions)
+		return;
+
+	for (i = 0; i < RTB__TRANSITION_COUNT; i++) {
+		tr = &elem->transitions->color[i];
+		rtb_animation_stop(&tr->anim);
+
+		if (tr->dest && *tr->dest == &tr->current)
+			*tr->dest = tr->to;
+	}
+
+	free(elem->transitions);
+	elem->transitions = NULL;
+}
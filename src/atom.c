@@ -25,6 +25,8 @@
  */
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -85,35 +87,19 @@ hash_meiyan(const char *str, size_t wrdlen)
 
 #define HASH(str, len) hash_meiyan(str, len)
 
-/**
- * nedtries stuff
- */
+#define MIN_CACHE_SLOTS 32
 
-static size_t
-dict_key_func(const struct rtb_atom_descriptor *node)
-{
-	return node->dict_entry.hash;
-}
-
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-function"
-NEDTRIE_GENERATE(static, rtb_atom_dict, rtb_atom_descriptor,
-		dict_entry.trie_entry, dict_key_func,
-		NEDTRIE_NOBBLEZEROS(rtb_atom_dict));
-#pragma GCC diagnostic pop
+/* maps rtb_type_ref_static() call sites to the descriptors they got. */
+struct rtb_type_cache_slot {
+	const void *key;
+	struct rtb_type_atom_descriptor *type;
+};
 
 static struct rtb_type_atom_descriptor *
-find_type_descriptor(struct rtb_atom_dict *dict,
+find_type_descriptor(struct rtb_dict *dict,
 		uint_t hash, const char *type_name, size_t len)
 {
-	struct rtb_atom_descriptor needle = {.dict_entry.hash = hash}, *ret;
-
-	ret = NEDTRIE_FIND(rtb_atom_dict, dict, &needle);
-
-	while (ret && strcmp(type_name, ret->name))
-		ret = NEDTRIE_NEXTLEAF(rtb_atom_dict, ret);
-
-	return (struct rtb_type_atom_descriptor *) ret;
+	return rtb_dict_find(dict, hash, type_name, len);
 }
 
 static struct rtb_type_atom_descriptor *
@@ -135,7 +121,7 @@ alloc_type_descriptor(uint_t hash, const char *type_name, size_t len,
 	need += len + 1;
 	ret = calloc(1, need);
 
-	ret->dict_entry.hash = hash;
+	ret->hash = hash;
 	ret->ref_count = 0;
 	ret->name = name = ((char *) ret) + name_start;
 
@@ -151,10 +137,100 @@ alloc_type_descriptor(uint_t hash, const char *type_name, size_t len,
 	}
 
 	ret->super[supertypes] = NULL;
+	ret->depth = supertypes;
 
 	return ret;
 }
 
+/**
+ * call-site cache
+ *
+ * open addressing with linear probing. entries are never removed one at
+ * a time: freeing any type empties the whole thing, which is rare
+ * enough not to matter and means nothing stale is ever handed back.
+ */
+
+static uint_t
+cache_hash(const void *key)
+{
+	uintptr_t k = (uintptr_t) key;
+
+	return (uint_t) ((k >> 3) * 2654435761u);
+}
+
+static struct rtb_type_atom_descriptor *
+cache_find(struct rutabaga *rtb, const void *key)
+{
+	struct rtb_type_cache_slot *slot;
+	uint_t i;
+
+	if (!rtb->atoms.cache)
+		return NULL;
+
+	for (i = cache_hash(key); ; i++) {
+		slot = &rtb->atoms.cache[i & rtb->atoms.cache_mask];
+
+		if (slot->key == key)
+			return slot->type;
+		if (!slot->key)
+			return NULL;
+	}
+}
+
+static void
+cache_put(struct rtb_type_cache_slot *slots, uint_t mask,
+		const void *key, struct rtb_type_atom_descriptor *type)
+{
+	uint_t i;
+
+	for (i = cache_hash(key); slots[i & mask].key; i++);
+
+	slots[i & mask].key  = key;
+	slots[i & mask].type = type;
+}
+
+static int
+cache_insert(struct rutabaga *rtb, const void *key,
+		struct rtb_type_atom_descriptor *type)
+{
+	struct rtb_type_cache_slot *slots;
+	uint_t i, nslots;
+
+	/* keep it at most half full */
+	nslots = rtb->atoms.cache ? rtb->atoms.cache_mask + 1 : 0;
+
+	if ((rtb->atoms.cache_count + 1) * 2 > nslots) {
+		nslots = nslots ? nslots * 2 : MIN_CACHE_SLOTS;
+
+		if (!(slots = calloc(nslots, sizeof(*slots))))
+			return -1;
+
+		for (i = 0; rtb->atoms.cache && i <= rtb->atoms.cache_mask; i++)
+			if (rtb->atoms.cache[i].key)
+				cache_put(slots, nslots - 1, rtb->atoms.cache[i].key,
+						rtb->atoms.cache[i].type);
+
+		free(rtb->atoms.cache);
+		rtb->atoms.cache = slots;
+		rtb->atoms.cache_mask = nslots - 1;
+	}
+
+	cache_put(rtb->atoms.cache, rtb->atoms.cache_mask, key, type);
+	rtb->atoms.cache_count++;
+	return 0;
+}
+
+static void
+cache_clear(struct rutabaga *rtb)
+{
+	if (!rtb->atoms.cache_count)
+		return;
+
+	memset(rtb->atoms.cache, 0,
+			(rtb->atoms.cache_mask + 1) * sizeof(*rtb->atoms.cache));
+	rtb->atoms.cache_count = 0;
+}
+
 
 /**
  * RTB_ATOM_TYPE public API
@@ -181,19 +257,22 @@ rtb_is_type(struct rtb_type_atom_descriptor *desc,
 	type_a = desc;
 	type_b = atom->type;
 
-	do {
-		if (type_a == type_b)
-			return 1;
-	} while ((type_b = type_b->super[0]));
+	if (type_a == type_b)
+		return 1;
 
-	return 0;
+	/* every type carries its full ancestry, so if `desc` is one of
+	 * them it can only be in one place. */
+	if (type_a->depth >= type_b->depth)
+		return 0;
+
+	return type_b->super[type_b->depth - type_a->depth - 1] == type_a;
 }
 
 struct rtb_type_atom_descriptor *
 rtb_type_ref(struct rtb_window *win, struct rtb_type_atom_descriptor *super,
 		const char *type_name)
 {
-	struct rtb_atom_dict *dict = &win->rtb->atoms.type;
+	struct rtb_dict *dict = &win->rtb->atoms.type;
 	struct rtb_type_atom_descriptor *type, *supertype;
 	uint_t hash;
 	int len;
@@ -210,13 +289,39 @@ rtb_type_ref(struct rtb_window *win, struct rtb_type_atom_descriptor *super,
 			return NULL;
 
 		type->dict = dict;
-		NEDTRIE_INSERT(rtb_atom_dict, dict, RTB_ATOM_DESCRIPTOR(type));
+
+		if (rtb_dict_insert(dict, hash, type->name, len, type)) {
+			free(type);
+			return NULL;
+		}
+
+		type->id = win->rtb->atoms.generation++;
 	}
 
 	type->ref_count++;
 	return type;
 }
 
+struct rtb_type_atom_descriptor *
+rtb_type_ref_cached(struct rtb_window *win,
+		struct rtb_type_atom_descriptor *super, const char *type_name,
+		const void *key)
+{
+	struct rtb_type_atom_descriptor *type;
+
+	if ((type = cache_find(win->rtb, key))) {
+		type->ref_count++;
+		return type;
+	}
+
+	if (!(type = rtb_type_ref(win, super, type_name)))
+		return NULL;
+
+	/* if this fails we just look it up again next time */
+	cache_insert(win->rtb, key, type);
+	return type;
+}
+
 int
 rtb_type_unref(struct rtb_type_atom_descriptor *type)
 {
@@ -226,7 +331,10 @@ rtb_type_unref(struct rtb_type_atom_descriptor *type)
 	rtb_type_unref(type->super[0]);
 
 	if (!--type->ref_count) {
-		NEDTRIE_REMOVE(rtb_atom_dict, type->dict, RTB_ATOM_DESCRIPTOR(type));
+		cache_clear(RTB_CONTAINER_OF(type->dict, struct rutabaga, atoms.type));
+
+		rtb_dict_remove(type->dict, type->hash, type->name,
+				strlen(type->name));
 		free(type);
 		return 0;
 	}
@@ -234,14 +342,28 @@ rtb_type_unref(struct rtb_type_atom_descriptor *type)
 	return type->ref_count;
 }
 
+void
+rtb_type_foreach(struct rutabaga *rtb,
+		void (*cb)(struct rtb_type_atom_descriptor *, void *ctx), void *ctx)
+{
+	struct rtb_dict_slot *slot;
+
+	RTB_DICT_FOREACH(slot, &rtb->atoms.type)
+		cb(slot->value, ctx);
+}
+
 void
 rtb_free_all_types(struct rutabaga *rtb)
 {
-	struct rtb_atom_descriptor *rad;
+	struct rtb_dict_slot *slot;
 
-	while ((rad = NEDTRIE_MIN(rtb_atom_dict, &rtb->atoms.type))) {
-		struct rtb_type_atom_descriptor *d = (void *) rad;
-		NEDTRIE_REMOVE(rtb_atom_dict, &rtb->atoms.type, rad);
-		free(d);
-	}
+	RTB_DICT_FOREACH(slot, &rtb->atoms.type)
+		free(slot->value);
+
+	rtb_dict_fini(&rtb->atoms.type);
+
+	free(rtb->atoms.cache);
+	rtb->atoms.cache = NULL;
+	rtb->atoms.cache_mask = 0;
+	rtb->atoms.cache_count = 0;
 }
@@ -42,7 +42,7 @@ attached(struct rtb_element *self,
 		struct rtb_element *parent, struct rtb_window *window)
 {
 	super.attached(self, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.container");
 }
 
@@ -0,0 +1,202 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rutabaga/dict.h>
+
+#define MIN_SLOTS 16
+
+/* grow once the table is 3/4 full */
+#define NEEDS_GROWTH(dict, count) \
+	(!(dict)->slots || (count) * 4 > ((dict)->mask + 1) * 3)
+
+static int
+key_matches(const struct rtb_dict_slot *slot,
+		uint32_t hash, const char *key, size_t len)
+{
+	if (slot->hash != hash || slot->len != len)
+		return 0;
+
+	if (len <= RTB_DICT_INLINE_KEY)
+		return !memcmp(slot->inline_key, key, len);
+
+	return !memcmp(slot->key, key, len);
+}
+
+static struct rtb_dict_slot *
+find_slot(struct rtb_dict *dict, uint32_t hash, const char *key, size_t len)
+{
+	struct rtb_dict_slot *slot;
+	uint32_t i, dist;
+
+	if (!dict->slots)
+		return NULL;
+
+	for (i = hash & dict->mask, dist = 1;; i = (i + 1) & dict->mask, dist++) {
+		slot = &dict->slots[i];
+
+		/* entries are ordered by distance, so once we reach one that's
+		 * closer to home than ours would be (or an empty slot), ours
+		 * isn't in the table. */
+		if (slot->dist < dist)
+			return NULL;
+
+		if (key_matches(slot, hash, key, len))
+			return slot;
+	}
+}
+
+static void
+place(struct rtb_dict_slot *slots, uint32_t mask, struct rtb_dict_slot entry)
+{
+	struct rtb_dict_slot *slot, displaced;
+	uint32_t i;
+
+	for (i = entry.hash & mask, entry.dist = 1;;
+			i = (i + 1) & mask, entry.dist++) {
+		slot = &slots[i];
+
+		if (!slot->dist) {
+			*slot = entry;
+			return;
+		}
+
+		/* take from the rich: whichever entry is further from home
+		 * gets the slot, and the other one keeps looking. */
+		if (slot->dist < entry.dist) {
+			displaced = *slot;
+			*slot = entry;
+			entry = displaced;
+		}
+	}
+}
+
+static int
+grow(struct rtb_dict *dict)
+{
+	struct rtb_dict_slot *slots, *slot;
+	uint32_t nslots;
+
+	nslots = dict->slots ? (dict->mask + 1) * 2 : MIN_SLOTS;
+
+	if (!(slots = calloc(nslots, sizeof(*slots))))
+		return -1;
+
+	RTB_DICT_FOREACH(slot, dict)
+		place(slots, nslots - 1, *slot);
+
+	free(dict->slots);
+	dict->slots = slots;
+	dict->mask  = nslots - 1;
+	return 0;
+}
+
+/**
+ * public API
+ */
+
+void
+rtb_dict_init(struct rtb_dict *dict)
+{
+	dict->slots = NULL;
+	dict->mask  = 0;
+	dict->count = 0;
+}
+
+void
+rtb_dict_fini(struct rtb_dict *dict)
+{
+	free(dict->slots);
+	rtb_dict_init(dict);
+}
+
+void *
+rtb_dict_find(struct rtb_dict *dict,
+		uint32_t hash, const char *key, size_t len)
+{
+	struct rtb_dict_slot *slot = find_slot(dict, hash, key, len);
+	return slot ? slot->value : NULL;
+}
+
+int
+rtb_dict_insert(struct rtb_dict *dict,
+		uint32_t hash, const char *key, size_t len, void *value)
+{
+	struct rtb_dict_slot entry = {
+		.hash  = hash,
+		.len   = len,
+		.value = value
+	};
+
+	if (len > UINT16_MAX)
+		return -1;
+
+	if (NEEDS_GROWTH(dict, dict->count + 1) && grow(dict))
+		return -1;
+
+	if (len <= RTB_DICT_INLINE_KEY)
+		memcpy(entry.inline_key, key, len);
+	else
+		entry.key = key;
+
+	place(dict->slots, dict->mask, entry);
+	dict->count++;
+	return 0;
+}
+
+void *
+rtb_dict_remove(struct rtb_dict *dict,
+		uint32_t hash, const char *key, size_t len)
+{
+	struct rtb_dict_slot *slot, *next;
+	void *value;
+	uint32_t i;
+
+	if (!(slot = find_slot(dict, hash, key, len)))
+		return NULL;
+
+	value = slot->value;
+	i = slot - dict->slots;
+
+	/* shift everything after us that isn't already home back by one,
+	 * rather than leaving a tombstone. */
+	for (;;) {
+		next = &dict->slots[(i + 1) & dict->mask];
+
+		if (next->dist <= 1)
+			break;
+
+		dict->slots[i] = *next;
+		dict->slots[i].dist--;
+		i = (i + 1) & dict->mask;
+	}
+
+	memset(&dict->slots[i], 0, sizeof(dict->slots[i]));
+	dict->count--;
+	return value;
+}
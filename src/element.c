@@ -45,6 +45,9 @@
 #include <rutabaga/mouse.h>
 
 #include "rtb_private/stdlib-allocator.h"
+#include "rtb_private/hit-grid.h"
+#include "rtb_private/update.h"
+#include "rtb_private/animation.h"
 #include "rtb_private/layout-debug.h"
 
 #include "wwrl/vector.h"
@@ -66,8 +69,12 @@ change_state(struct rtb_element *self, rtb_elem_state_t state)
 	if (self->state == state)
 		return 0;
 
+	/* only our own style depends on our state, so children only need
+	 * restyling if something they inherit changed. */
 	self->state = state;
+	self->restyle_targeted = 1;
 	self->restyle(self);
+	self->restyle_targeted = 0;
 
 	return 0;
 }
@@ -213,6 +220,17 @@ reflow_leafward(struct rtb_element *self,
 		iter->reflow(iter, self, direction);
 }
 
+/**
+ * the parent's hit grid has to follow every move and resize, including
+ * ones that never make it to a reflow.
+ */
+static void
+update_hit_cells(struct rtb_element *self)
+{
+	if (self->parent && self->parent != self)
+		rtb__hit_grid_update(self->parent, self);
+}
+
 static int
 reflow(struct rtb_element *self,
 		struct rtb_element *instigator, rtb_ev_direction_t direction)
@@ -230,6 +248,8 @@ reflow(struct rtb_element *self,
 
 	rtb_stylequad_update_geometry(&self->stylequad, &self->rect);
 
+	update_hit_cells(self);
+
 	switch (direction) {
 	case RTB_DIRECTION_ROOTWARD:
 		if (!reflow_rootward(self, instigator, RTB_DIRECTION_ROOTWARD))
@@ -257,9 +277,8 @@ reload_style(struct rtb_element *self)
 	/* layout-related properties trigger a reflow if they change, so
 	 * we'll handle them first. */
 
-#define ASSIGN_LAYOUT_FLOAT(pname, dest) do {                         \
-	prop = rtb_style_query_prop(self,                                 \
-			pname, RTB_STYLE_PROP_FLOAT, 0);                          \
+#define ASSIGN_LAYOUT_FLOAT(id, dest) do {                            \
+	prop = rtb_style_computed_prop(self, id, 0);                      \
 	if (!prop)                                                        \
 		break;                                                        \
 	if (self->dest != prop->flt                                       \
@@ -270,30 +289,38 @@ reload_style(struct rtb_element *self)
 		self->dest = prop->flt;                                       \
 } while (0)
 
-	ASSIGN_LAYOUT_FLOAT("min-width", min_size.w);
-	ASSIGN_LAYOUT_FLOAT("min-height", min_size.h);
+	ASSIGN_LAYOUT_FLOAT(RTB_STYLE_PROP_ID_MIN_WIDTH, min_size.w);
+	ASSIGN_LAYOUT_FLOAT(RTB_STYLE_PROP_ID_MIN_HEIGHT, min_size.h);
 
 #undef ASSIGN_LAYOUT_FLOAT
 
-#define LOAD_PROP(name, type, member, load_func)                      \
-	if ((prop = rtb_style_query_prop(self, name, type, 0))            \
+#define LOAD_PROP(id, member, load_func)                              \
+	if ((prop = rtb_style_computed_prop(self, id, 0))                 \
 			&& !load_func(&self->stylequad, &prop->member))           \
 
-#define LOAD_COLOR(name, load_func)                                   \
-		LOAD_PROP(name, RTB_STYLE_PROP_COLOR, color, load_func) {     \
-			rtb_elem_mark_dirty(self);                                \
-		}
+/* colours go through rtb__transition_color() so that they can fade
+ * between states if the style asks for it. */
+#define LOAD_COLOR(id, slot, member)                                  \
+	if ((prop = rtb_style_computed_prop(self, id, 0))                 \
+			&& !rtb__transition_color(self, slot,                     \
+				&self->stylequad.properties.member, &prop->color)) {  \
+		rtb_elem_mark_dirty(self);                                    \
+	}
 
-#define LOAD_TEXTURE(name, load_func)                                 \
-		LOAD_PROP(name, RTB_STYLE_PROP_TEXTURE, texture, load_func) { \
+#define LOAD_TEXTURE(id, load_func)                                   \
+		LOAD_PROP(id, texture, load_func) {                           \
 			rtb_elem_mark_dirty(self);                                \
 		}
 
-	LOAD_COLOR("background-color", rtb_stylequad_set_background_color);
-	LOAD_COLOR("border-color", rtb_stylequad_set_border_color);
+	LOAD_COLOR(RTB_STYLE_PROP_ID_BACKGROUND_COLOR,
+			RTB__TRANSITION_BG_COLOR, bg_color);
+	LOAD_COLOR(RTB_STYLE_PROP_ID_BORDER_COLOR,
+			RTB__TRANSITION_BORDER_COLOR, border_color);
 
-	LOAD_TEXTURE("border-image", rtb_stylequad_set_border_image);
-	LOAD_TEXTURE("background-image", rtb_stylequad_set_background_image);
+	LOAD_TEXTURE(RTB_STYLE_PROP_ID_BORDER_IMAGE,
+			rtb_stylequad_set_border_image);
+	LOAD_TEXTURE(RTB_STYLE_PROP_ID_BACKGROUND_IMAGE,
+			rtb_stylequad_set_background_image);
 
 #undef LOAD_TEXTURE
 #undef LOAD_COLOR
@@ -303,9 +330,18 @@ reload_style(struct rtb_element *self)
 		rtb_elem_reflow_rootward(self);
 }
 
+static int
+inherited_changed(const struct rtb_computed_style *a,
+		const struct rtb_computed_style *b)
+{
+	return a->props[RTB_STYLE_PROP_ID_COLOR] != b->props[RTB_STYLE_PROP_ID_COLOR]
+		|| a->props[RTB_STYLE_PROP_ID_FONT] != b->props[RTB_STYLE_PROP_ID_FONT];
+}
+
 static void
 restyle(struct rtb_element *self)
 {
+	struct rtb_computed_style old;
 	struct rtb_element *iter;
 
 	assert(self->window->state != RTB_STATE_UNATTACHED);
@@ -313,10 +349,25 @@ restyle(struct rtb_element *self)
 	if (!self->style)
 		self->style = rtb_style_for_element(self, self->window->style_list);
 
+	/* parents restyle before their children, so whatever we inherit
+	 * has already been computed */
+	old = self->computed;
+	rtb_style_compute(self);
 	reload_style(self);
 
-	TAILQ_FOREACH(iter, &self->children, child)
+	self->window->restyled++;
+
+	if (self->restyle_targeted
+			&& !inherited_changed(&old, &self->computed))
+		return;
+
+	/* a targeted restyle stays targeted on the way down: a child whose
+	 * own inherited values come out the same stops there. */
+	TAILQ_FOREACH(iter, &self->children, child) {
+		iter->restyle_targeted = self->restyle_targeted;
 		iter->restyle(iter);
+		iter->restyle_targeted = 0;
+	}
 }
 
 /**
@@ -356,7 +407,8 @@ attached(struct rtb_element *self,
 	self->parent = parent;
 	self->window = window;
 
-	self->type = rtb_type_ref(window, NULL, "net.illest.rutabaga.element");
+	self->type = rtb_type_ref_static(window, NULL,
+			"net.illest.rutabaga.element");
 
 	self->layout_cb(self);
 
@@ -372,6 +424,9 @@ detached(struct rtb_element *self,
 {
 	struct rtb_element *iter;
 
+	rtb__elem_handle_release(self);
+	rtb__transitions_free(self);
+
 	self->parent = NULL;
 	self->window = NULL;
 
@@ -397,10 +452,21 @@ child_detached(struct rtb_element *self, struct rtb_element *child)
 	child->surface = NULL;
 }
 
+static unsigned
+combine_redraw_rates(unsigned a, unsigned b)
+{
+	/* if anything wants the redraw without a limit, it gets it. */
+	if (!a || !b)
+		return 0;
+
+	return (a > b) ? a : b;
+}
+
 static void
 mark_dirty(struct rtb_element *self)
 {
 	struct rtb_surface *surface = self->surface;
+	unsigned rate = self->max_redraw_rate;
 
 	if (!surface)
 		return;
@@ -414,10 +480,17 @@ mark_dirty(struct rtb_element *self)
 	}
 
 	if (!surface || surface->surface_state == RTB_SURFACE_INVALID
-			|| !rtb_elem_is_visible(self)
-			|| self->render_entry.tqe_next || self->render_entry.tqe_prev)
+			|| !rtb_elem_is_visible(self))
 		return;
 
+	if (self->render_entry.tqe_next || self->render_entry.tqe_prev) {
+		self->queued_redraw_rate =
+			combine_redraw_rates(self->queued_redraw_rate, rate);
+		return;
+	}
+
+	self->queued_redraw_rate = rate;
+
 	if (surface->in_redraw)
 		TAILQ_INSERT_TAIL(&surface->next_frame_render_queue,
 				self, render_entry);
@@ -431,6 +504,18 @@ mark_dirty(struct rtb_element *self)
  * public API
  */
 
+/* events that the base element does something with */
+#define BASE_EVENTS (                \
+	RTB_EVENT_BIT(RTB_MOUSE_ENTER)      \
+	| RTB_EVENT_BIT(RTB_MOUSE_LEAVE)    \
+	| RTB_EVENT_BIT(RTB_DRAG_ENTER)     \
+	| RTB_EVENT_BIT(RTB_DRAG_LEAVE)     \
+	| RTB_EVENT_BIT(RTB_FOCUS)          \
+	| RTB_EVENT_BIT(RTB_UNFOCUS)        \
+	| RTB_EVENT_BIT(RTB_MOUSE_DOWN)     \
+	| RTB_EVENT_BIT(RTB_MOUSE_UP)       \
+	| RTB_EVENT_BIT(RTB_DRAG_DROP))
+
 int
 rtb_elem_deliver_event(struct rtb_element *self, const struct rtb_event *e)
 {
@@ -441,6 +526,14 @@ rtb_elem_deliver_event(struct rtb_element *self, const struct rtb_event *e)
 	if (self->state == RTB_STATE_UNATTACHED)
 		return 0;
 
+	/* an element that has no handler for this event, doesn't override
+	 * on_event(), and doesn't change state because of it has nothing to
+	 * do here. this is most of the tree for something like motion events
+	 * bubbling up to the window. */
+	if (self->on_event == on_event
+			&& !((self->handled_events | BASE_EVENTS) & RTB_EVENT_BIT(e->type)))
+		return 0;
+
 	ret = self->on_event(self, e);
 	ret = (rtb_handle(self, e) != -1) || ret;
 
@@ -581,6 +674,8 @@ rtb_elem_set_position_from_point(struct rtb_element *self,
 {
 	self->x = floorf(pos->x);
 	self->y = floorf(pos->y);
+
+	update_hit_cells(self);
 }
 
 void
@@ -602,6 +697,8 @@ rtb_elem_set_size(struct rtb_element *self, struct rtb_size *sz)
 {
 	self->w = sz->w;
 	self->h = sz->h;
+
+	update_hit_cells(self);
 }
 
 int
@@ -630,18 +727,28 @@ rtb_elem_add_child(struct rtb_element *self, struct rtb_element *child,
 	assert(child->restyle);
 	assert(child->mark_dirty);
 
-	if (where == RTB_ADD_HEAD)
+	if (where == RTB_ADD_HEAD) {
+		child->sibling_order = TAILQ_EMPTY(&self->children) ? 0
+			: TAILQ_FIRST(&self->children)->sibling_order - 1;
 		TAILQ_INSERT_HEAD(&self->children, child, child);
-	else
+	} else {
+		child->sibling_order = TAILQ_EMPTY(&self->children) ? 0
+			: TAILQ_LAST(&self->children, rtb_elem_children)->sibling_order + 1;
 		TAILQ_INSERT_TAIL(&self->children, child, child);
+	}
+
+	self->nchildren++;
+	rtb__hit_grid_update(self, child);
 
 	if (self->state != RTB_STATE_UNATTACHED) {
 		self->child_attached(self, child);
 
 		rtb_style_resolve_list(self->window, self->window->style_list);
 
-		if (self->window->state != RTB_STATE_UNATTACHED)
+		if (self->window->state != RTB_STATE_UNATTACHED) {
+			rtb_style_prefetch_fonts(child);
 			self->restyle(self);
+		}
 
 		self->reflow(self, child, RTB_DIRECTION_ROOTWARD);
 	}
@@ -651,6 +758,11 @@ void
 rtb_elem_remove_child(struct rtb_element *self, struct rtb_element *child)
 {
 	TAILQ_REMOVE(&self->children, child, child);
+	self->nchildren--;
+
+	rtb__hit_grid_remove(self, child);
+	if (self->nchildren < RTB_HIT_GRID_THRESHOLD / 2)
+		rtb__hit_grid_free(self);
 
 	if (self->state == RTB_STATE_UNATTACHED)
 		return;
@@ -738,6 +850,9 @@ void
 rtb_elem_fini(struct rtb_element *self)
 {
 	rtb_stylequad_fini(&self->stylequad);
+	rtb__hit_grid_free(self);
+	rtb__elem_handle_release(self);
+	rtb__transitions_free(self);
 	VECTOR_FREE(&self->handlers);
 	rtb_type_unref(self->type);
 }
@@ -33,21 +33,51 @@
 #include <rutabaga/element.h>
 
 
+/**
+ * returns the index of the first handler in `bucket` or a later one.
+ */
+static unsigned
+bucket_start(const struct rtb_element *target, unsigned bucket)
+{
+	const struct rtb_event_handler *handlers = target->handlers.data;
+	unsigned lo, hi, mid;
+
+	lo = 0;
+	hi = target->handlers.size;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+
+		if (rtb_event_bucket(handlers[mid].type) < bucket)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
 int
 rtb_handle(struct rtb_element *target, const struct rtb_event *ev)
 {
-	const struct rtb_event_handler *handlers, *h;
-	unsigned i, size, num_handlers, ret;
+	const struct rtb_event_handler *h;
+	unsigned i, bucket, num_handlers, ret;
+
+	if (!(target->handled_events & RTB_EVENT_BIT(ev->type)))
+		return -1;
 
 	num_handlers = 0;
 	ret = 0;
 
-	handlers = target->handlers.data;
-	size     = target->handlers.size;
+	bucket = rtb_event_bucket(ev->type);
+
+	for (i = bucket_start(target, bucket); i < target->handlers.size; i++) {
+		h = &target->handlers.data[i];
 
-	for (i = 0; i < size; i++) {
-		h = &handlers[i];
+		if (rtb_event_bucket(h->type) != bucket)
+			break;
 
+		/* the shared bucket has several types in it */
 		if (h->type != ev->type)
 			continue;
 
@@ -94,7 +124,10 @@ rtb_register_handler(struct rtb_element *target, rtb_ev_type_t type,
 	assert(target);
 	assert(cb);
 
-	VECTOR_PUSH_BACK(&target->handlers, &handler);
+	/* after any handlers already in this bucket */
+	VECTOR_INSERT(&target->handlers,
+			bucket_start(target, rtb_event_bucket(type) + 1), &handler);
+	target->handled_events |= RTB_EVENT_BIT(type);
 	return 0;
 }
 
@@ -102,21 +135,29 @@ void
 rtb_unregister_handler(struct rtb_element *target, rtb_ev_type_t type,
 		rtb_event_cb_t cb, void *ctx)
 {
-	const struct rtb_event_handler *handlers;
-	int i, size;
+	const struct rtb_event_handler *h;
+	unsigned i, bucket;
 
 	assert(target);
 
-	handlers = target->handlers.data;
-	size = target->handlers.size;
+	bucket = rtb_event_bucket(type);
 
-	for (i = 0; i < size; i++) {
-		const struct rtb_event_handler *h = &handlers[i];
+	for (i = bucket_start(target, bucket); i < target->handlers.size; i++) {
+		h = &target->handlers.data[i];
+
+		if (rtb_event_bucket(h->type) != bucket)
+			return;
 
 		if (h->type == type && h->callback.cb == cb
 				&& h->callback.ctx == ctx) {
 			VECTOR_ERASE(&target->handlers, i);
-			return;
+			break;
 		}
 	}
+
+	/* clear the bucket's bit if that was the last handler in it */
+	i = bucket_start(target, bucket);
+	if (i >= target->handlers.size
+			|| rtb_event_bucket(target->handlers.data[i].type) != bucket)
+		target->handled_events &= ~RTB_EVENT_BIT(type);
 }
@@ -0,0 +1,197 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include <uv.h>
+
+#include <rutabaga/rutabaga.h>
+#include <rutabaga/frame-stats.h>
+
+#include "rtb_private/frame-stats.h"
+
+#define NSEC_PER_SEC  1000000000ull
+#define NSEC_PER_MSEC 1000000ull
+
+#define HISTORY_MASK (RTB_FRAME_STATS_HISTORY - 1)
+
+#define DEFAULT_DEADLINE (NSEC_PER_SEC / 60)
+
+static uint64_t
+thread_cpu_time(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+		return 0;
+
+	return (ts.tv_sec * NSEC_PER_SEC) + ts.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+static struct rtb_frame_timing *
+last_frame(struct rtb_frame_stats *self)
+{
+	if (!self->frames)
+		return NULL;
+
+	return &self->history[(self->frames - 1) & HISTORY_MASK];
+}
+
+/**
+ * recording
+ */
+
+void
+rtb__frame_stats_begin(struct rtb_frame_stats *self, uint64_t now)
+{
+	memset(&self->current, 0, sizeof(self->current));
+	self->current.at[RTB_FRAME_PHASE_START] = now;
+	self->cpu_start = thread_cpu_time();
+}
+
+void
+rtb__frame_stats_mark(struct rtb_frame_stats *self, rtb_frame_phase_t phase)
+{
+	self->current.at[phase] = uv_hrtime();
+}
+
+void
+rtb__frame_stats_drawn(struct rtb_frame_stats *self, unsigned restyled)
+{
+	struct rtb_frame_timing *timing;
+
+	timing = &self->history[self->frames & HISTORY_MASK];
+	*timing = self->current;
+
+	timing->serial = ++self->frames;
+	timing->restyled = restyled;
+}
+
+void
+rtb__frame_stats_swapped(struct rtb_frame_stats *self)
+{
+	struct rtb_frame_timing *timing;
+	uint64_t took, cpu_end;
+	unsigned bucket;
+
+	if (!(timing = last_frame(self)) || timing->at[RTB_FRAME_PHASE_SWAP])
+		return;
+
+	timing->at[RTB_FRAME_PHASE_SWAP] = uv_hrtime();
+
+	if ((cpu_end = thread_cpu_time()) && self->cpu_start)
+		timing->cpu_time = cpu_end - self->cpu_start;
+
+	took = timing->at[RTB_FRAME_PHASE_SWAP]
+		- timing->at[RTB_FRAME_PHASE_START];
+
+	bucket = took / (RTB_FRAME_STATS_BUCKET_MSEC * NSEC_PER_MSEC);
+	if (bucket >= RTB_FRAME_STATS_BUCKETS)
+		bucket = RTB_FRAME_STATS_BUCKETS - 1;
+
+	self->histogram[bucket]++;
+
+	if (took > self->deadline) {
+		timing->missed_deadline = 1;
+		self->missed_deadlines++;
+	}
+}
+
+void
+rtb__frame_stats_presented(struct rtb_frame_stats *self, uint64_t when)
+{
+	struct rtb_frame_timing *timing;
+
+	if (!(timing = last_frame(self))
+			|| !timing->at[RTB_FRAME_PHASE_SWAP]
+			|| timing->at[RTB_FRAME_PHASE_PRESENT])
+		return;
+
+	timing->at[RTB_FRAME_PHASE_PRESENT] = when;
+}
+
+void
+rtb__frame_stats_init(struct rtb_frame_stats *self)
+{
+	memset(self, 0, sizeof(*self));
+	self->deadline = DEFAULT_DEADLINE;
+}
+
+/**
+ * public API
+ */
+
+int
+rtb_frame_stats_get_timing(const struct rtb_frame_stats *self,
+		unsigned frames_ago, struct rtb_frame_timing *timing)
+{
+	if (frames_ago >= RTB_FRAME_STATS_HISTORY || frames_ago >= self->frames)
+		return -1;
+
+	*timing = self->history[(self->frames - 1 - frames_ago) & HISTORY_MASK];
+	return 0;
+}
+
+unsigned
+rtb_frame_stats_percentile(const struct rtb_frame_stats *self,
+		float fraction)
+{
+	uint64_t total, want, seen;
+	int i;
+
+	for (total = 0, i = 0; i < RTB_FRAME_STATS_BUCKETS; i++)
+		total += self->histogram[i];
+
+	if (!total)
+		return 0;
+
+	want = (uint64_t) (fraction * total);
+
+	for (seen = 0, i = 0; i < RTB_FRAME_STATS_BUCKETS - 1; i++) {
+		seen += self->histogram[i];
+
+		if (seen >= want)
+			break;
+	}
+
+	return (i + 1) * RTB_FRAME_STATS_BUCKET_MSEC;
+}
+
+void
+rtb_frame_stats_reset(struct rtb_frame_stats *self)
+{
+	/* leaves the frame in progress alone */
+	self->frames = 0;
+	self->missed_deadlines = 0;
+
+	memset(self->histogram, 0, sizeof(self->histogram));
+	memset(self->history, 0, sizeof(self->history));
+}
@@ -0,0 +1,302 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * a spatial hash over an element's children. each child goes into every
+ * cell its rect touches, and a point only has to be tested against the
+ * children in its cell. children that cover a lot of cells go in a
+ * separate list that's always checked instead.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <rutabaga/rutabaga.h>
+#include <rutabaga/element.h>
+
+#include "rtb_private/hit-grid.h"
+#include "rtb_private/stdlib-allocator.h"
+
+#include "wwrl/vector.h"
+
+#define MIN_BUCKETS    64
+#define MAX_CHILD_CELLS 16
+
+#define MIN_CELL_SIZE  16.f
+#define MAX_CELL_SIZE  512.f
+
+typedef enum {
+	NOT_INDEXED = 0,
+	IN_CELLS,
+	OVERSIZED
+} hit_cells_state_t;
+
+VECTOR(rtb_hit_grid_bucket, struct rtb_element *);
+
+struct rtb_hit_grid {
+	float cell_size;
+
+	uint32_t mask;
+	struct rtb_hit_grid_bucket *buckets;
+	struct rtb_hit_grid_bucket oversized;
+};
+
+static uint32_t
+cell_hash(const struct rtb_hit_grid *grid, int x, int y)
+{
+	return (((uint32_t) x * 73856093u) ^ ((uint32_t) y * 19349663u))
+		& grid->mask;
+}
+
+static int
+cell_of(const struct rtb_hit_grid *grid, float coord)
+{
+	return (int) floorf(coord / grid->cell_size);
+}
+
+static void
+bucket_add(struct rtb_hit_grid_bucket *bucket, struct rtb_element *elem)
+{
+	if (!bucket->data)
+		VECTOR_INIT(bucket, &stdlib_allocator, 4);
+
+	VECTOR_PUSH_BACK(bucket, &elem);
+}
+
+static void
+bucket_remove(struct rtb_hit_grid_bucket *bucket, struct rtb_element *elem)
+{
+	size_t i;
+
+	for (i = 0; i < bucket->size; i++) {
+		if (bucket->data[i] == elem) {
+			bucket->data[i] = *VECTOR_BACK(bucket);
+			bucket->size--;
+			return;
+		}
+	}
+}
+
+static void
+grid_remove(struct rtb_hit_grid *grid, struct rtb_element *child)
+{
+	int x, y;
+
+	switch ((hit_cells_state_t) child->hit_cells.state) {
+	case NOT_INDEXED:
+		return;
+
+	case OVERSIZED:
+		bucket_remove(&grid->oversized, child);
+		break;
+
+	case IN_CELLS:
+		for (y = child->hit_cells.y; y <= child->hit_cells.y2; y++)
+			for (x = child->hit_cells.x; x <= child->hit_cells.x2; x++)
+				bucket_remove(&grid->buckets[cell_hash(grid, x, y)], child);
+		break;
+	}
+
+	child->hit_cells.state = NOT_INDEXED;
+}
+
+static void
+grid_insert(struct rtb_hit_grid *grid, struct rtb_element *child)
+{
+	int x, y, x1, y1, x2, y2;
+
+	/* go by the size rather than x2 and y2, which aren't recomputed
+	 * until the child reflows */
+	x1 = cell_of(grid, child->x);
+	y1 = cell_of(grid, child->y);
+	x2 = cell_of(grid, child->x + child->w);
+	y2 = cell_of(grid, child->y + child->h);
+
+	if ((int64_t) (x2 - x1 + 1) * (y2 - y1 + 1) > MAX_CHILD_CELLS) {
+		bucket_add(&grid->oversized, child);
+		child->hit_cells.state = OVERSIZED;
+		return;
+	}
+
+	for (y = y1; y <= y2; y++)
+		for (x = x1; x <= x2; x++)
+			bucket_add(&grid->buckets[cell_hash(grid, x, y)], child);
+
+	child->hit_cells.x  = x1;
+	child->hit_cells.y  = y1;
+	child->hit_cells.x2 = x2;
+	child->hit_cells.y2 = y2;
+	child->hit_cells.state = IN_CELLS;
+}
+
+static void
+grid_free(struct rtb_hit_grid *grid)
+{
+	uint32_t i;
+
+	for (i = 0; i <= grid->mask; i++)
+		if (grid->buckets[i].data)
+			VECTOR_FREE(&grid->buckets[i]);
+
+	if (grid->oversized.data)
+		VECTOR_FREE(&grid->oversized);
+
+	free(grid->buckets);
+	free(grid);
+}
+
+static struct rtb_hit_grid *
+grid_build(struct rtb_element *parent)
+{
+	struct rtb_hit_grid *grid;
+	struct rtb_element *iter;
+	uint32_t nbuckets;
+	float extent;
+
+	if (!(grid = calloc(1, sizeof(*grid))))
+		goto err_grid;
+
+	for (nbuckets = MIN_BUCKETS; nbuckets < parent->nchildren; nbuckets *= 2);
+
+	if (!(grid->buckets = calloc(nbuckets, sizeof(*grid->buckets))))
+		goto err_buckets;
+
+	grid->mask = nbuckets - 1;
+
+	/* size the cells to the children, so that most of them land in one
+	 * to four cells */
+	extent = 0.f;
+	TAILQ_FOREACH(iter, &parent->children, child)
+		extent += fmaxf(iter->w, iter->h);
+
+	grid->cell_size = fminf(fmaxf(extent / parent->nchildren,
+				MIN_CELL_SIZE), MAX_CELL_SIZE);
+
+	TAILQ_FOREACH(iter, &parent->children, child) {
+		iter->hit_cells.state = NOT_INDEXED;
+		grid_insert(grid, iter);
+	}
+
+	return grid;
+
+err_buckets:
+	free(grid);
+err_grid:
+	return NULL;
+}
+
+static void
+consider(struct rtb_element **best, struct rtb_hit_grid_bucket *bucket,
+		struct rtb_point pt)
+{
+	struct rtb_element *elem;
+	size_t i;
+
+	for (i = 0; i < bucket->size; i++) {
+		elem = bucket->data[i];
+
+		if (*best && elem->sibling_order <= (*best)->sibling_order)
+			continue;
+
+		if (RTB_POINT_IN_RECT(pt, *elem)
+				&& elem->visibility != RTB_FULLY_OBSCURED)
+			*best = elem;
+	}
+}
+
+/**
+ * private API
+ */
+
+struct rtb_element *
+rtb__hit_grid_child_at(struct rtb_element *parent, struct rtb_point pt)
+{
+	struct rtb_hit_grid *grid = parent->hit_grid;
+	struct rtb_element *best, *iter;
+
+	/* rebuild once the grid is well outgrown, so buckets stay short */
+	if (grid && parent->nchildren > 4 * (grid->mask + 1)) {
+		rtb__hit_grid_free(parent);
+		grid = NULL;
+	}
+
+	if (!grid)
+		grid = parent->hit_grid = grid_build(parent);
+
+	if (!grid) {
+		TAILQ_FOREACH_REVERSE(iter, &parent->children,
+				rtb_elem_children, child)
+			if (RTB_POINT_IN_RECT(pt, *iter)
+					&& iter->visibility != RTB_FULLY_OBSCURED)
+				return iter;
+
+		return NULL;
+	}
+
+	/* later siblings are drawn on top, so the highest sibling_order
+	 * wins, same as walking the children back to front. */
+	best = NULL;
+	consider(&best, &grid->buckets[cell_hash(grid,
+				cell_of(grid, pt.x), cell_of(grid, pt.y))], pt);
+	consider(&best, &grid->oversized, pt);
+
+	return best;
+}
+
+void
+rtb__hit_grid_update(struct rtb_element *parent, struct rtb_element *child)
+{
+	if (!parent->hit_grid)
+		return;
+
+	grid_remove(parent->hit_grid, child);
+	grid_insert(parent->hit_grid, child);
+}
+
+void
+rtb__hit_grid_remove(struct rtb_element *parent, struct rtb_element *child)
+{
+	if (!parent->hit_grid)
+		return;
+
+	grid_remove(parent->hit_grid, child);
+}
+
+void
+rtb__hit_grid_free(struct rtb_element *parent)
+{
+	struct rtb_element *iter;
+
+	if (!parent->hit_grid)
+		return;
+
+	TAILQ_FOREACH(iter, &parent->children, child)
+		iter->hit_cells.state = NOT_INDEXED;
+
+	grid_free(parent->hit_grid);
+	parent->hit_grid = NULL;
+}
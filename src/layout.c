@@ -366,7 +366,7 @@ hdistribute_many(struct rtb_element *elem,
 	}
 
 	iter = TAILQ_LAST(&elem->children, rtb_elem_children);
-	iter->x = elem->inner_rect.x2 - iter->w;
+	rtb_elem_set_position(iter, elem->inner_rect.x2 - iter->w, iter->y);
 }
 
 void
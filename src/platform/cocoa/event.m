@@ -53,6 +53,12 @@ frame_timer_callback(CFRunLoopTimerRef timer, void *info)
 	rtb__cocoa_draw_frame(cwin, 0);
 }
 
+void
+rtb__platform_request_frame(struct rtb_window *win)
+{
+	/* the frame timer runs continuously here, nothing to do. */
+}
+
 /**
  * uv shim
  */
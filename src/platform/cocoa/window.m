@@ -33,6 +33,7 @@
 #include <rutabaga/platform.h>
 
 #include "rtb_private/window_impl.h"
+#include "rtb_private/frame-stats.h"
 #include "cocoa_rtb.h"
 
 #if __MAC_OS_X_VERSION_MAX_ALLOWED < 101200
@@ -626,8 +627,10 @@ rtb__cocoa_draw_frame(struct cocoa_rtb_window *self, int force)
 
 	rtb_window_lock(win);
 
-	if (rtb_window_draw(win, force))
+	if (rtb_window_draw(win, force)) {
 		[self->gl_ctx flushBuffer];
+		rtb__frame_stats_swapped(&win->frame_stats);
+	}
 
 	rtb_window_unlock(win);
 }
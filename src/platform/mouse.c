@@ -32,6 +32,8 @@
 #include <rutabaga/mouse.h>
 #include <rutabaga/platform.h>
 
+#include "rtb_private/hit-grid.h"
+
 /**
  * event dispatching
  */
@@ -62,6 +64,12 @@ dispatch_drag_event(struct rtb_window *window, rtb_ev_type_t type,
 			.y = delta.h}
 	};
 
+	if (b->target && (b->target->flags & RTB_ELEM_MOTION_HISTORY)
+			&& window->mouse.motion_history.size) {
+		ev.history = window->mouse.motion_history.data;
+		ev.history_size = window->mouse.motion_history.size;
+	}
+
 	if (also_dispatch_to && also_dispatch_to != b->target)
 		rtb_dispatch_raw(also_dispatch_to, RTB_EVENT(&ev));
 
@@ -302,6 +310,21 @@ point_in_visible_element(const struct rtb_element *elem, struct rtb_point pt)
 	return RTB_POINT_IN_RECT(pt, *elem) && elem->visibility != RTB_FULLY_OBSCURED;
 }
 
+static struct rtb_element *
+child_under_cursor(struct rtb_element *parent, struct rtb_point cursor)
+{
+	struct rtb_element *iter;
+
+	if (parent->nchildren >= RTB_HIT_GRID_THRESHOLD)
+		return rtb__hit_grid_child_at(parent, cursor);
+
+	TAILQ_FOREACH_REVERSE(iter, &parent->children, rtb_elem_children, child)
+		if (point_in_visible_element(iter, cursor))
+			return iter;
+
+	return NULL;
+}
+
 static struct rtb_element *
 retarget_descend(struct rtb_element *ret, struct rtb_window *win,
 		struct rtb_point cursor)
@@ -309,21 +332,16 @@ retarget_descend(struct rtb_element *ret, struct rtb_window *win,
 	struct rtb_element *iter;
 	int hit = 0;
 
-descend:
-	TAILQ_FOREACH_REVERSE(iter, &ret->children, rtb_elem_children, child) {
-		if (point_in_visible_element(iter, cursor)) {
-			hit = 1;
-
-			ret = iter;
-			ret->mouse_in = 1;
+	while ((iter = child_under_cursor(ret, cursor))) {
+		hit = 1;
 
-			dispatch_simple_mouse_event(win, ret, RTB_MOUSE_ENTER, -1, cursor);
+		ret = iter;
+		ret->mouse_in = 1;
 
-			if (win->mouse.buttons_down)
-				dispatch_drag_enter(win, ret, cursor);
+		dispatch_simple_mouse_event(win, ret, RTB_MOUSE_ENTER, -1, cursor);
 
-			goto descend;
-		}
+		if (win->mouse.buttons_down)
+			dispatch_drag_enter(win, ret, cursor);
 	}
 
 	if (hit)
@@ -454,6 +472,24 @@ rtb__platform_mouse_motion(struct rtb_window *win, struct rtb_point pt)
 		win->mouse.previous = *RTB_UPCAST(&win->mouse, rtb_point);
 }
 
+void
+rtb__platform_mouse_motion_queue(struct rtb_window *win, struct rtb_point pt)
+{
+	VECTOR_PUSH_BACK(&win->mouse.motion_history, &pt);
+}
+
+void
+rtb__platform_mouse_motion_flush(struct rtb_window *win)
+{
+	struct rtb_mouse *mouse = &win->mouse;
+
+	if (!mouse->motion_history.size)
+		return;
+
+	rtb__platform_mouse_motion(win, *VECTOR_BACK(&mouse->motion_history));
+	VECTOR_CLEAR(&mouse->motion_history);
+}
+
 void
 rtb__platform_mouse_wheel(struct rtb_window *win, struct rtb_point pt,
 		float delta)
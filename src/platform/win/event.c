@@ -35,6 +35,7 @@
 #include <rutabaga/platform.h>
 
 #include "rtb_private/window_impl.h"
+#include "rtb_private/frame-stats.h"
 
 #include "win_rtb.h"
 
@@ -55,8 +56,10 @@ draw_frame(struct win_rtb_window *self, int force)
 {
 	LOCK(self);
 
-	if (rtb_window_draw(RTB_WINDOW(self), force))
+	if (rtb_window_draw(RTB_WINDOW(self), force)) {
 		SwapBuffers(self->dc);
+		rtb__frame_stats_swapped(&RTB_WINDOW(self)->frame_stats);
+	}
 
 	UNLOCK(self);
 }
@@ -320,6 +323,12 @@ run_application_event_loop(struct rutabaga *r)
  * public API
  */
 
+void
+rtb__platform_request_frame(struct rtb_window *win)
+{
+	/* the frame timer runs continuously here, nothing to do. */
+}
+
 void
 rtb_event_loop_init(struct rutabaga *r)
 {
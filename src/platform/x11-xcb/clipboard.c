@@ -29,6 +29,8 @@
 #include <rutabaga/window.h>
 #include <rutabaga/platform.h>
 
+#include "rtb_private/utf8.h"
+
 #include "xrtb.h"
 
 void
@@ -121,6 +123,10 @@ rtb_paste_from_clipboard(struct rtb_window *rwin, rtb_utf8_t **buf)
 
 	memcpy(*buf, xcb_get_property_value(prop), ret);
 	free(prop);
+
+	/* whoever owns the selection can put anything they like in there,
+	 * so don't hand back anything past the first invalid sequence. */
+	ret = rtb__u8_valid_prefix(*buf, ret);
 	(*buf)[ret] = 0;
 	return ret;
 
@@ -49,6 +49,7 @@
 #include <rutabaga/keyboard.h>
 
 #include "rtb_private/util.h"
+#include "rtb_private/frame-stats.h"
 
 #include "xrtb.h"
 
@@ -173,7 +174,9 @@ handle_mouse_motion(struct xrtb_window *win, const xcb_generic_event_t *_ev)
 	CAST_EVENT_TO(xcb_motion_notify_event_t);
 	struct rtb_window *rwin = RTB_WINDOW(win);
 
-	rtb__platform_mouse_motion(rwin, rtb_phy_to_point(rwin,
+	/* a fast mouse sends far more of these than we can usefully
+	 * dispatch. they're flushed in drain_xcb_event_queue(). */
+	rtb__platform_mouse_motion_queue(rwin, rtb_phy_to_point(rwin,
 			RTB_MAKE_PHY_POINT(ev->event_x, ev->event_y)));
 }
 
@@ -260,6 +263,10 @@ handle_visibility_notify(struct xrtb_window *win, xcb_generic_event_t *_ev)
 		win->visibility = RTB_FULLY_OBSCURED;
 		break;
 	}
+
+	/* frames requested while we were hidden didn't draw anything. */
+	if (win->dirty && win->visibility != RTB_FULLY_OBSCURED)
+		rtb__platform_request_frame(RTB_WINDOW(win));
 }
 
 static void
@@ -424,7 +431,7 @@ handle_compositor_change(struct xrtb_window *win, xcb_generic_event_t *_ev)
 	xcb_xfixes_selection_notify_event_t *ev = (void *) _ev;
 	int swap_blocks_until_vsync = !ev->owner;
 
-	eglSwapInterval(win->egl_dpy, swap_blocks_until_vsync);
+	xrtb_window_set_swap_interval(win, swap_blocks_until_vsync);
 }
 
 /**
@@ -455,6 +462,159 @@ handle_secret_xlib_event(Display *dpy, xcb_generic_event_t *ev)
 	return 0;
 }
 
+/**
+ * frame scheduling
+ *
+ * frames are drawn on demand. rtb__platform_request_frame() arms a
+ * one-shot timer, no sooner than wait_msec after the last frame. if the
+ * X server has the Present extension, each frame we draw also asks to be
+ * told about the next vblank, and the next frame waits for that instead.
+ * when nothing asks for a frame, nothing wakes us up.
+ */
+
+/* if the vblank notification goes missing (e.g. we've been unmapped),
+ * don't wait for it forever. */
+#define VBLANK_TIMEOUT_MSEC 100
+
+static void frame_cb(uv_timer_t *);
+
+static void
+arm_frame_timer(struct xrtb_frame_timer *timer, uint64_t delay)
+{
+	timer->scheduled = 1;
+	uv_timer_start(RTB_UPCAST(timer, uv_timer_s), frame_cb, delay, 0);
+}
+
+static void
+schedule_frame(struct xrtb_frame_timer *timer)
+{
+	uint64_t since_last;
+
+	timer->wanted = 1;
+
+	/* whatever is in flight will pick the request up when it's done. */
+	if (timer->in_frame || timer->waiting_for_vblank || timer->scheduled)
+		return;
+
+	since_last = uv_now(RTB_UPCAST(timer, uv_timer_s)->loop)
+		- timer->last_frame;
+
+	arm_frame_timer(timer, (since_last < timer->wait_msec)
+			? timer->wait_msec - since_last : 0);
+}
+
+/* the frame we were waiting on has made it to the screen. */
+static void
+frame_presented(struct xrtb_frame_timer *timer, int on_vblank)
+{
+	if (!timer->waiting_for_vblank)
+		return;
+
+	timer->waiting_for_vblank = 0;
+	uv_timer_stop(RTB_UPCAST(timer, uv_timer_s));
+	timer->scheduled = 0;
+
+	if (!timer->wanted)
+		return;
+
+	if (on_vblank)
+		arm_frame_timer(timer, 0);
+	else
+		schedule_frame(timer);
+}
+
+static void
+render_thread_presented_cb(uv_async_t *handle)
+{
+	struct xrtb_render_thread *rt =
+		RTB_CONTAINER_OF(handle, struct xrtb_render_thread, presented);
+	struct rtb_window *win = RTB_WINDOW(rt->xwin);
+	uint64_t presented_at;
+
+	uv_mutex_lock(&rt->lock);
+	presented_at = rt->presented_at;
+	uv_mutex_unlock(&rt->lock);
+
+	rtb_window_lock(win);
+	rtb__frame_stats_presented(&win->frame_stats, presented_at);
+	rtb_window_unlock(win);
+
+	/* the swap may or may not have waited for vblank, depending on
+	 * whether there's a compositor. */
+	frame_presented(&rt->xwin->xrtb->frame_timer, 0);
+}
+
+#ifdef RTB_XCB_PRESENT
+
+static int
+request_vblank(struct xrtb_frame_timer *timer)
+{
+	xcb_connection_t *conn = timer->xwin->xrtb->xcb_conn;
+
+	if (!timer->use_present)
+		return 0;
+
+	xcb_present_notify_msc(conn, timer->xwin->xcb_win,
+			++timer->present_serial, timer->last_msc + 1, 0, 0);
+	xcb_flush(conn);
+	return 1;
+}
+
+static void
+handle_present_event(struct xrtb_window *win, xcb_generic_event_t *_ev)
+{
+	CAST_EVENT_TO(xcb_present_complete_notify_event_t);
+	struct xrtb_frame_timer *timer = &win->xrtb->frame_timer;
+
+	if (ev->event_type != XCB_PRESENT_EVENT_COMPLETE_NOTIFY
+			|| ev->serial != timer->present_serial)
+		return;
+
+	/* ust is CLOCK_MONOTONIC in microseconds, same as uv_hrtime(). */
+	rtb__frame_stats_presented(&RTB_WINDOW(win)->frame_stats,
+			ev->ust * 1000);
+
+	timer->last_msc = ev->msc;
+	frame_presented(timer, 1);
+}
+
+#else
+
+static int
+request_vblank(struct xrtb_frame_timer *timer)
+{
+	return 0;
+}
+
+#endif
+
+static void
+wakeup_cb(uv_async_t *handle)
+{
+	schedule_frame(RTB_CONTAINER_OF(handle, struct xrtb_frame_timer, wakeup));
+}
+
+void
+rtb__platform_request_frame(struct rtb_window *rwin)
+{
+	struct xrtb_window *self = RTB_WINDOW_AS(rwin, xrtb_window);
+	struct xrtb_frame_timer *timer;
+	uv_thread_t current;
+
+	/* nothing to schedule until the event loop is up. it'll draw the
+	 * first frame on its own. */
+	if (!self->xrtb || !(timer = &self->xrtb->frame_timer)->xwin)
+		return;
+
+	current = uv_thread_self();
+	if (!uv_thread_equal(&current, &timer->loop_thread)) {
+		uv_async_send(&timer->wakeup);
+		return;
+	}
+
+	schedule_frame(timer);
+}
+
 /**
  * actual event loop
  */
@@ -465,6 +625,11 @@ handle_generic_event(struct xrtb_window *win, xcb_generic_event_t *ev)
 	struct xcb_rutabaga *xrtb = win->xrtb;
 	int type = ev->response_type & ~0x80;
 
+	/* anything else has to see the cursor where it was when the event
+	 * was sent. */
+	if (type != XCB_MOTION_NOTIFY)
+		rtb__platform_mouse_motion_flush(RTB_WINDOW(win));
+
 	switch (type) {
 	/**
 	 * mouse events
@@ -519,7 +684,7 @@ handle_generic_event(struct xrtb_window *win, xcb_generic_event_t *ev)
 		break;
 
 	case XCB_EXPOSE:
-		win->dirty = 1;
+		rtb_elem_mark_dirty(RTB_ELEMENT(win));
 		break;
 
 	case XCB_VISIBILITY_NOTIFY:
@@ -546,6 +711,16 @@ handle_generic_event(struct xrtb_window *win, xcb_generic_event_t *ev)
 		handle_selection_request(win, ev);
 		break;
 
+#ifdef RTB_XCB_PRESENT
+	case XCB_GE_GENERIC:
+		if (xrtb->present && ((xcb_ge_generic_event_t *) ev)->extension
+				== xrtb->present->major_opcode)
+			handle_present_event(win, ev);
+		else
+			handle_secret_xlib_event(xrtb->dpy, ev);
+		break;
+#endif
+
 	/**
 	 * ~mystery~ events
 	 */
@@ -581,6 +756,8 @@ drain_xcb_event_queue(xcb_connection_t *conn, struct rtb_window *win)
 			return -1;
 	}
 
+	rtb__platform_mouse_motion_flush(win);
+
 	if (win->need_reconfigure) {
 		rtb_window_reinit(win);
 		win->need_reconfigure = 0;
@@ -612,30 +789,75 @@ xcb_poll_cb(uv_poll_t *_handle, int status, int events)
 static void
 frame_cb(uv_timer_t *_handle)
 {
+	struct xrtb_render_thread *rt;
 	struct xrtb_frame_timer *timer;
 	struct xrtb_window *xwin;
 	struct rtb_window *win;
 
+	int drew;
+
 	timer = RTB_DOWNCAST(_handle, xrtb_frame_timer, uv_timer_s);
 	xwin = timer->xwin;
 	win = RTB_WINDOW(xwin);
+	rt = &xwin->render_thread;
+
+	timer->scheduled = 0;
+
+	/* timed out waiting for vblank. */
+	if (timer->waiting_for_vblank) {
+		timer->waiting_for_vblank = 0;
+
+		if (!timer->wanted)
+			return;
+	}
+
+	timer->in_frame = 1;
+	timer->wanted = 0;
 
 	rtb_window_lock(win);
 	drain_xcb_event_queue(xwin->xrtb->xcb_conn, win);
 
-	if (rtb_window_draw(win, 0))
+	timer->last_frame = uv_now(_handle->loop);
+
+	if (rt->running) {
+		xrtb_render_thread_begin_frame(rt);
+		drew = rtb_window_draw(win, 0);
+		xrtb_render_thread_end_frame(rt, drew);
+	} else if ((drew = rtb_window_draw(win, 0)))
 		eglSwapBuffers(xwin->egl_dpy, xwin->egl_surface);
 
+	if (drew)
+		rtb__frame_stats_swapped(&win->frame_stats);
+
 	drain_xcb_event_queue(xwin->xrtb->xcb_conn, win);
 	rtb_window_unlock(win);
+
+	timer->in_frame = 0;
+
+	if (drew && rt->running) {
+		/* no timeout here: the render thread always answers, and
+		 * drawing again before it does could hand it a frame that it's
+		 * still reading from. */
+		timer->waiting_for_vblank = 1;
+	} else if (drew && request_vblank(timer)) {
+		timer->waiting_for_vblank = 1;
+		arm_frame_timer(timer, VBLANK_TIMEOUT_MSEC);
+	} else if (timer->wanted)
+		schedule_frame(timer);
 }
 
 static int
 frame_timer_init(struct xrtb_frame_timer *timer)
 {
-	/* FIXME: get FPS from xrandr? or xcomposite? whatever. */
-
+	/* only used when we can't wait for vblank. */
 	timer->wait_msec = 10;
+	timer->loop_thread = uv_thread_self();
+
+#ifdef RTB_XCB_PRESENT
+	timer->use_present =
+		timer->xwin->xrtb->present && timer->xwin->xrtb->present->present;
+#endif
+
 	return 0;
 }
 
@@ -649,14 +871,17 @@ rtb_event_loop_init(struct rutabaga *r)
 	uv_poll_init(&r->event_loop, RTB_UPCAST(&xrtb->xcb_poll, uv_poll_s),
 			xcb_get_file_descriptor(xrtb->xcb_conn));
 
+	uv_timer_init(&r->event_loop, RTB_UPCAST(&xrtb->frame_timer, uv_timer_s));
+	uv_async_init(&r->event_loop, &xrtb->frame_timer.wakeup, wakeup_cb);
 	xrtb->frame_timer.xwin = xwin;
 	frame_timer_init(&xrtb->frame_timer);
-	uv_timer_init(&r->event_loop, RTB_UPCAST(&xrtb->frame_timer, uv_timer_s));
+
+	xrtb_render_thread_start(&xwin->render_thread, &r->event_loop,
+			render_thread_presented_cb);
 
 	uv_poll_start(RTB_UPCAST(&xrtb->xcb_poll, uv_poll_s), UV_READABLE,
 			xcb_poll_cb);
-	uv_timer_start(RTB_UPCAST(&xrtb->frame_timer, uv_timer_s),
-			frame_cb, 0, xrtb->frame_timer.wait_msec);
+	schedule_frame(&xrtb->frame_timer);
 }
 
 void
@@ -675,8 +900,12 @@ void
 rtb_event_loop_fini(struct rutabaga *r)
 {
 	struct xcb_rutabaga *xrtb = (void *) r;
+	struct xrtb_window *xwin = (void *) r->win;
+
+	xrtb_render_thread_stop(&xwin->render_thread);
 
 	uv_close((void *) RTB_UPCAST(&xrtb->frame_timer, uv_timer_s), NULL);
+	uv_close((void *) &xrtb->frame_timer.wakeup, NULL);
 	uv_close((void *) RTB_UPCAST(&xrtb->xcb_poll, uv_poll_s), NULL);
 
 	uv_run(&r->event_loop, UV_RUN_NOWAIT);
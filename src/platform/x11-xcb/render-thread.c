@@ -0,0 +1,337 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <uv.h>
+
+#include <rutabaga/opengl.h>
+
+#include <rutabaga/rutabaga.h>
+#include <rutabaga/window.h>
+
+#include "xrtb.h"
+
+/**
+ * render thread
+ */
+
+static void
+present(struct xrtb_render_thread *self, GLuint read_fbo,
+		struct xrtb_render_frame *frame)
+{
+	struct xrtb_window *xwin = self->xwin;
+	int w = frame->size.w, h = frame->size.h;
+	GLsync released;
+
+	glWaitSync(frame->fence, 0, GL_TIMEOUT_IGNORED);
+	glDeleteSync(frame->fence);
+	frame->fence = NULL;
+
+	/* framebuffer objects aren't shared between contexts, so we keep
+	 * our own and re-attach each time in case the texture was resized. */
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo);
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, frame->texture, 0);
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, w, h, 0, 0, w, h,
+			GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	/* the event loop waits on this before drawing into the texture
+	 * again, so it can't overwrite a frame we haven't finished reading. */
+	released = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+
+	uv_mutex_lock(&self->lock);
+	frame->released = released;
+	uv_mutex_unlock(&self->lock);
+
+	eglSwapBuffers(xwin->egl_dpy, xwin->egl_surface);
+}
+
+static void
+render_thread(void *ctx)
+{
+	struct xrtb_render_thread *self = ctx;
+	struct xrtb_window *xwin = self->xwin;
+	struct xrtb_render_frame *frame;
+	int swap_interval = -1;
+	GLuint read_fbo;
+
+	eglBindAPI(EGL_OPENGL_API);
+	eglMakeCurrent(xwin->egl_dpy,
+			xwin->egl_surface, xwin->egl_surface, self->egl_ctx);
+
+	glGenFramebuffers(1, &read_fbo);
+
+	uv_mutex_lock(&self->lock);
+
+	for (;;) {
+		while (!self->pending && !self->quit)
+			uv_cond_wait(&self->cond, &self->lock);
+
+		if (self->quit)
+			break;
+
+		frame = self->pending;
+		self->pending = NULL;
+
+		if (swap_interval != self->swap_interval) {
+			swap_interval = self->swap_interval;
+			eglSwapInterval(xwin->egl_dpy, swap_interval);
+		}
+
+		uv_mutex_unlock(&self->lock);
+
+		present(self, read_fbo, frame);
+
+		uv_mutex_lock(&self->lock);
+		self->presented_at = uv_hrtime();
+		uv_async_send(&self->presented);
+	}
+
+	uv_mutex_unlock(&self->lock);
+
+	glDeleteFramebuffers(1, &read_fbo);
+	eglMakeCurrent(xwin->egl_dpy,
+			EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+/**
+ * event loop thread
+ */
+
+static void
+frame_fini(struct xrtb_render_frame *frame)
+{
+	if (frame->fence)
+		glDeleteSync(frame->fence);
+	if (frame->released)
+		glDeleteSync(frame->released);
+
+	if (frame->fbo) {
+		glDeleteFramebuffers(1, &frame->fbo);
+		glDeleteTextures(1, &frame->texture);
+	}
+
+	memset(frame, 0, sizeof(*frame));
+}
+
+static void
+frame_resize(struct xrtb_render_frame *frame, struct rtb_phy_size size)
+{
+	if (!frame->fbo) {
+		glGenTextures(1, &frame->texture);
+		glGenFramebuffers(1, &frame->fbo);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, frame->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+			size.w, size.h, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frame->fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, frame->texture, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	frame->size = size;
+}
+
+static struct xrtb_render_frame *
+back_frame(struct xrtb_render_thread *self)
+{
+	return &self->frames[self->presenting ^ 1];
+}
+
+/**
+ * binds the frame we're about to draw into. that's always the one the
+ * render thread didn't get last, but it may still be reading it from an
+ * earlier frame, so we wait on the GPU for it to let go first.
+ */
+void
+xrtb_render_thread_begin_frame(struct xrtb_render_thread *self)
+{
+	struct rtb_window *win = RTB_WINDOW(self->xwin);
+	struct xrtb_render_frame *frame = back_frame(self);
+	GLsync released;
+
+	uv_mutex_lock(&self->lock);
+	released = frame->released;
+	frame->released = NULL;
+	uv_mutex_unlock(&self->lock);
+
+	if (released) {
+		glWaitSync(released, 0, GL_TIMEOUT_IGNORED);
+		glDeleteSync(released);
+	}
+
+	if (frame->size.w != win->phy_size.w || frame->size.h != win->phy_size.h)
+		frame_resize(frame, win->phy_size);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, frame->fbo);
+}
+
+void
+xrtb_render_thread_end_frame(struct xrtb_render_thread *self, int drew)
+{
+	struct xrtb_render_frame *frame = back_frame(self);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	/* if nothing was drawn, the frame still holds whatever it had and
+	 * we'll draw into it again next time. */
+	if (!drew)
+		return;
+
+	frame->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+
+	uv_mutex_lock(&self->lock);
+	self->pending = frame;
+	uv_cond_signal(&self->cond);
+	uv_mutex_unlock(&self->lock);
+
+	self->presenting ^= 1;
+}
+
+void
+xrtb_render_thread_set_swap_interval(struct xrtb_render_thread *self,
+		int interval)
+{
+	uv_mutex_lock(&self->lock);
+	self->swap_interval = interval;
+	uv_mutex_unlock(&self->lock);
+}
+
+static void
+teardown(struct xrtb_render_thread *self)
+{
+	uv_cond_destroy(&self->cond);
+	uv_mutex_destroy(&self->lock);
+
+	eglDestroyContext(self->xwin->egl_dpy, self->egl_ctx);
+	self->enabled = 0;
+}
+
+int
+xrtb_render_thread_start(struct xrtb_render_thread *self,
+		uv_loop_t *loop, uv_async_cb presented_cb)
+{
+	if (!self->enabled)
+		return -1;
+
+	self->quit = 0;
+	self->pending = NULL;
+
+	uv_async_init(loop, &self->presented, presented_cb);
+
+	if (uv_thread_create(&self->thread, render_thread, self)) {
+		ERR("couldn't start render thread\n");
+		uv_close((void *) &self->presented, NULL);
+
+		/* draw straight to the window instead. */
+		teardown(self);
+		return -1;
+	}
+
+	self->running = 1;
+	return 0;
+}
+
+void
+xrtb_render_thread_stop(struct xrtb_render_thread *self)
+{
+	if (!self->running)
+		return;
+
+	uv_mutex_lock(&self->lock);
+	self->quit = 1;
+	uv_cond_signal(&self->cond);
+	uv_mutex_unlock(&self->lock);
+
+	uv_thread_join(&self->thread);
+	uv_close((void *) &self->presented, NULL);
+
+	self->running = 0;
+}
+
+/**
+ * the window's own context never draws to the window surface once the
+ * render thread has it, so it needs to be able to go current without
+ * one. `egl_ctx` has to share objects with it.
+ */
+int
+xrtb_render_thread_init(struct xrtb_render_thread *self,
+		struct xrtb_window *xwin, EGLContext egl_ctx)
+{
+	const char *exts;
+
+	memset(self, 0, sizeof(*self));
+	self->xwin = xwin;
+	self->swap_interval = 1;
+
+	exts = eglQueryString(xwin->egl_dpy, EGL_EXTENSIONS);
+	if (!exts || !strstr(exts, "EGL_KHR_surfaceless_context")) {
+		ERR("EGL_KHR_surfaceless_context isn't supported, "
+				"not using a render thread\n");
+		return -1;
+	}
+
+	self->egl_ctx = egl_ctx;
+
+	uv_mutex_init(&self->lock);
+	uv_cond_init(&self->cond);
+
+	self->enabled = 1;
+	return 0;
+}
+
+/**
+ * the window's context has to be current. the frames are only deleted
+ * once the render thread has been joined.
+ */
+void
+xrtb_render_thread_fini(struct xrtb_render_thread *self)
+{
+	if (!self->enabled)
+		return;
+
+	xrtb_render_thread_stop(self);
+
+	frame_fini(&self->frames[0]);
+	frame_fini(&self->frames[1]);
+
+	teardown(self);
+}
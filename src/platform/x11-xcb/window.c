@@ -236,6 +236,10 @@ window_impl_rtb_alloc(void)
 	if (!(self = calloc(1, sizeof(*self))))
 		goto err_malloc;
 
+	/* a window's render thread swaps buffers on this display while the
+	 * event loop is still using it. */
+	XInitThreads();
+
 	if (!(self->dpy = dpy = XOpenDisplay(NULL))) {
 		ERR("can't open X display\n");
 		goto err_dpy;
@@ -283,6 +287,9 @@ window_impl_rtb_alloc(void)
 
 	self->empty_cursor = create_empty_cursor(self);
 	self->xfixes = xcb_get_extension_data(self->xcb_conn, &xcb_xfixes_id);
+#ifdef RTB_XCB_PRESENT
+	self->present = xcb_get_extension_data(self->xcb_conn, &xcb_present_id);
+#endif
 
 	return (struct rutabaga *) self;
 
@@ -425,7 +432,7 @@ find_egl_config(Display *dpy, EGLDisplay egl_dpy, int want_transparent)
 }
 
 static EGLContext
-new_egl_ctx(EGLDisplay egl_dpy, EGLContext cfg)
+new_egl_ctx(EGLDisplay egl_dpy, EGLContext cfg, EGLContext share)
 {
 	static const EGLint attribs[] = {
 		EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
@@ -437,7 +444,29 @@ new_egl_ctx(EGLDisplay egl_dpy, EGLContext cfg)
 		EGL_NONE
 	};
 
-	return eglCreateContext(egl_dpy, cfg, EGL_NO_CONTEXT, attribs);
+	return eglCreateContext(egl_dpy, cfg, share, attribs);
+}
+
+/**
+ * with a render thread, the window surface belongs to it and our context
+ * only ever draws into framebuffer objects.
+ */
+static EGLSurface
+draw_surface(struct xrtb_window *self)
+{
+	if (self->render_thread.enabled)
+		return EGL_NO_SURFACE;
+
+	return self->egl_surface;
+}
+
+void
+xrtb_window_set_swap_interval(struct xrtb_window *self, int interval)
+{
+	if (self->render_thread.enabled)
+		xrtb_render_thread_set_swap_interval(&self->render_thread, interval);
+	else
+		eglSwapInterval(self->egl_dpy, interval);
 }
 
 static int
@@ -463,7 +492,7 @@ set_xprop(xcb_connection_t *c, xcb_window_t win,
 
 static void
 set_swap_interval(xcb_connection_t *xcb_conn,
-		xcb_atom_t compositor, EGLDisplay egl_dpy)
+		xcb_atom_t compositor, struct xrtb_window *win)
 {
 	int swap_blocks_until_vsync = 1;
 
@@ -480,7 +509,7 @@ set_swap_interval(xcb_connection_t *xcb_conn,
 		}
 	}
 
-	eglSwapInterval(egl_dpy, swap_blocks_until_vsync);
+	xrtb_window_set_swap_interval(win, swap_blocks_until_vsync);
 }
 
 /**
@@ -595,6 +624,8 @@ window_impl_open(struct rutabaga *rtb,
 
 	int default_screen;
 	EGLConfig egl_config;
+	EGLContext render_ctx;
+	EGLSurface surface;
 	XVisualInfo *visual;
 
 	uint32_t event_mask =
@@ -664,7 +695,7 @@ window_impl_open(struct rutabaga *rtb,
 
 	eglBindAPI(EGL_OPENGL_API);
 
-	self->egl_ctx = new_egl_ctx(self->egl_dpy, egl_config);
+	self->egl_ctx = new_egl_ctx(self->egl_dpy, egl_config, EGL_NO_CONTEXT);
 	if (!self->egl_ctx) {
 		ERR("couldn't create EGL context: %d\n", eglGetError());
 		goto err_egl_ctx;
@@ -727,14 +758,25 @@ window_impl_open(struct rutabaga *rtb,
 	if (set_xprop(xcb_conn, self->xcb_win, XCB_ATOM_WM_NAME, opt->title))
 		set_xprop(xcb_conn, self->xcb_win, XCB_ATOM_WM_NAME, "");
 
-	if (eglMakeCurrent(self->egl_dpy, self->egl_surface, self->egl_surface,
+	if (opt->flags & RTB_WINDOW_OPEN_THREADED_RENDERING) {
+		render_ctx = new_egl_ctx(self->egl_dpy, egl_config, self->egl_ctx);
+
+		if (!render_ctx)
+			ERR("couldn't create render thread EGL context: %d\n",
+					eglGetError());
+		else if (xrtb_render_thread_init(&self->render_thread,
+					self, render_ctx))
+			eglDestroyContext(self->egl_dpy, render_ctx);
+	}
+
+	surface = draw_surface(self);
+	if (eglMakeCurrent(self->egl_dpy, surface, surface,
 				self->egl_ctx) != EGL_TRUE) {
 		ERR("couldn't activate EGL surface: %d\n", eglGetError());
 		goto err_egl_make_current;
 	}
 
-	set_swap_interval(xcb_conn, xrtb->atoms.compositor,
-			self->egl_dpy);
+	set_swap_interval(xcb_conn, xrtb->atoms.compositor, self);
 
 	ck_map = xcb_map_window_checked(xcb_conn, self->xcb_win);
 	if ((err = xcb_request_check(xcb_conn, ck_map))) {
@@ -758,11 +800,18 @@ window_impl_open(struct rutabaga *rtb,
 			| XCB_XFIXES_SELECTION_EVENT_MASK_SELECTION_CLIENT_CLOSE);
 	}
 
+#ifdef RTB_XCB_PRESENT
+	if (xrtb->present && xrtb->present->present)
+		xcb_present_select_input(xcb_conn, xcb_generate_id(xcb_conn),
+				self->xcb_win, XCB_PRESENT_EVENT_MASK_COMPLETE_NOTIFY);
+#endif
+
 	uv_mutex_init(&self->lock);
 	return RTB_WINDOW(self);
 
 err_win_map:
 err_egl_make_current:
+	xrtb_render_thread_fini(&self->render_thread);
 err_egl_surface:
 	xcb_destroy_window(xcb_conn, self->xcb_win);
 
@@ -786,8 +835,14 @@ void
 window_impl_close(struct rtb_window *rwin)
 {
 	struct xrtb_window *self = RTB_WINDOW_AS(rwin, xrtb_window);
+	EGLSurface surface = draw_surface(self);
 
+	/* the render thread's frames belong to our context, which has to be
+	 * current to delete them. */
 	eglBindAPI(EGL_OPENGL_API);
+	eglMakeCurrent(self->egl_dpy, surface, surface, self->egl_ctx);
+
+	xrtb_render_thread_fini(&self->render_thread);
 
 	eglMakeCurrent(self->egl_dpy,
 		EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
@@ -808,13 +863,13 @@ void
 rtb_window_lock(struct rtb_window *rwin)
 {
 	struct xrtb_window *self = RTB_WINDOW_AS(rwin, xrtb_window);
+	EGLSurface surface = draw_surface(self);
 
 	uv_mutex_lock(&self->lock);
 	XLockDisplay(self->xrtb->dpy);
 
 	eglBindAPI(EGL_OPENGL_API);
-	eglMakeCurrent(self->egl_dpy,
-		self->egl_surface, self->egl_surface, self->egl_ctx);
+	eglMakeCurrent(self->egl_dpy, surface, surface, self->egl_ctx);
 }
 
 void
@@ -34,6 +34,10 @@
 #include <xcb/xcb_cursor.h>
 #include <xcb/xfixes.h>
 
+#ifdef RTB_XCB_PRESENT
+#include <xcb/present.h>
+#endif
+
 #include <xkbcommon/xkbcommon.h>
 
 #include <GL/glx.h>
@@ -45,7 +49,74 @@
 struct xrtb_frame_timer {
 	RTB_INHERIT(uv_timer_s);
 	struct xrtb_window *xwin;
+
+	/* minimum time between frames when we can't pace on vblank. */
 	unsigned int wait_msec;
+	uint64_t last_frame;
+	uint64_t last_msc;
+
+	int scheduled;
+	int wanted;
+	int in_frame;
+	int waiting_for_vblank;
+
+	/* frame requests from threads other than the event loop's. */
+	uv_async_t wakeup;
+	uv_thread_t loop_thread;
+
+	int use_present;
+	uint32_t present_serial;
+};
+
+/**
+ * with RTB_WINDOW_OPEN_THREADED_RENDERING, the event loop thread still
+ * does all of the drawing, but into an offscreen frame rather than the
+ * window. the render thread owns the window's EGL surface, copies each
+ * finished frame onto it and swaps buffers, so the event loop doesn't
+ * block on vsync.
+ */
+
+struct xrtb_render_frame {
+	/* owned by the event loop thread's context */
+	GLuint texture;
+	GLuint fbo;
+
+	struct rtb_phy_size size;
+	GLsync fence;
+
+	/* signalled once the render thread has copied the frame out.
+	 * protected by the render thread's `lock`. */
+	GLsync released;
+};
+
+struct xrtb_render_thread {
+	struct xrtb_window *xwin;
+
+	int enabled;
+	int running;
+
+	uv_thread_t thread;
+	uv_mutex_t lock;
+	uv_cond_t cond;
+
+	/* tells the event loop that a frame has been swapped. */
+	uv_async_t presented;
+
+	/* shares objects with the window's context. */
+	EGLContext egl_ctx;
+
+	/* the frame last handed to the render thread; we draw into the
+	 * other one. */
+	struct xrtb_render_frame frames[2];
+	int presenting;
+
+	/* everything below is protected by `lock`. */
+	struct xrtb_render_frame *pending;
+	int swap_interval;
+	int quit;
+
+	/* uv_hrtime() when the last frame's swap returned */
+	uint64_t presented_at;
 };
 
 struct xrtb_uv_poll {
@@ -60,6 +131,7 @@ struct xcb_rutabaga {
 	xcb_connection_t *xcb_conn;
 
 	const xcb_query_extension_reply_t *xfixes;
+	const xcb_query_extension_reply_t *present;
 
 	struct {
 		xcb_atom_t
@@ -121,12 +193,27 @@ struct xrtb_window {
 	EGLContext egl_ctx;
 	EGLSurface egl_surface;
 
+	struct xrtb_render_thread render_thread;
+
 	uint16_t numlock_mask;
 	uint16_t capslock_mask;
 	uint16_t shiftlock_mask;
 	uint16_t modeswitch_mask;
 };
 
+void xrtb_window_set_swap_interval(struct xrtb_window *, int interval);
+
+int  xrtb_render_thread_init(struct xrtb_render_thread *,
+		struct xrtb_window *xwin, EGLContext egl_ctx);
+void xrtb_render_thread_fini(struct xrtb_render_thread *);
+int  xrtb_render_thread_start(struct xrtb_render_thread *,
+		uv_loop_t *loop, uv_async_cb presented_cb);
+void xrtb_render_thread_stop(struct xrtb_render_thread *);
+void xrtb_render_thread_begin_frame(struct xrtb_render_thread *);
+void xrtb_render_thread_end_frame(struct xrtb_render_thread *, int drew);
+void xrtb_render_thread_set_swap_interval(struct xrtb_render_thread *,
+		int interval);
+
 rtb_keysym_t xrtb_keyboard_translate_keysym(xcb_keysym_t xsym,
 		rtb_utf32_t *chr);
 
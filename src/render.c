@@ -43,8 +43,8 @@ rtb_render_use_style_fg(struct rtb_render_context *ctx,
 		struct rtb_element *from)
 {
 	const struct rtb_style_property_definition *prop;
-	prop = rtb_style_query_prop(from,
-			"background-color", RTB_STYLE_PROP_COLOR, 1);
+	prop = rtb_style_computed_prop(from,
+			RTB_STYLE_PROP_ID_BACKGROUND_COLOR, 1);
 
 	rtb_render_set_color(ctx,
 			prop->color.r,
@@ -58,8 +58,11 @@ rtb_render_use_style_bg(struct rtb_render_context *ctx,
 		struct rtb_element *from)
 {
 	const struct rtb_style_property_definition *prop;
-	prop = rtb_style_query_prop(from,
-			"color", RTB_STYLE_PROP_COLOR, 1);
+
+	/* the computed colour is inherited, but this one only ever came
+	 * from the element's own style. */
+	prop = rtb_style_query_prop_by_id(from,
+			RTB_STYLE_PROP_ID_COLOR, RTB_STYLE_PROP_COLOR, 1);
 
 	rtb_render_set_color(ctx,
 			prop->color.r,
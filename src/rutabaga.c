@@ -52,7 +52,11 @@ rtb_new(void)
 
 	self->owns_application_event_loop = 1;
 
-	RTB_DICT_INIT(&self->atoms.type);
+	rtb_dict_init(&self->atoms.type);
+	self->atoms.generation = 0;
+	self->atoms.cache = NULL;
+	self->atoms.cache_mask = 0;
+	self->atoms.cache_count = 0;
 
 	memcpy(&self->allocator, &stdlib_allocator,
 			sizeof(self->allocator));
@@ -33,10 +33,9 @@
 
 #version 150
 
+/* grayscale atlas. gamma is applied when glyphs are rasterised. */
+
 uniform sampler2D tex;
-uniform vec3 atlas_pixel;
-uniform float gamma;
-in float shift;
 
 in vec2 uv;
 in vec4 front_color;
@@ -44,44 +43,5 @@ out vec4 frag_color;
 
 void main()
 {
-	// LCD Off
-	if (atlas_pixel.z == 1.0) {
-		float a = texture(tex, uv).r;
-		frag_color = front_color * pow(a, 1.0 / gamma);
-		return;
-	}
-
-	// LCD On
-	vec4 current  = texture(tex, uv);
-	vec4 previous = texture(tex, uv + vec2(-1.,0.) * atlas_pixel.xy);
-	vec4 next     = texture(tex, uv + vec2(+1.,0.) * atlas_pixel.xy);
-
-	current = pow(current,  vec4(1.0 / gamma));
-	previous= pow(previous, vec4(1.0 / gamma));
-
-	float r = current.r;
-	float g = current.g;
-	float b = current.b;
-
-	if (shift <= 0.333) {
-		float z = shift / 0.333;
-		r = mix(current.r, previous.b, z);
-		g = mix(current.g, current.r,  z);
-		b = mix(current.b, current.g,  z);
-	} else if (shift <= 0.666) {
-		float z = (shift - 0.33) / 0.333;
-		r = mix(previous.b, previous.g, z);
-		g = mix(current.r,  previous.b, z);
-		b = mix(current.g,  current.r,  z);
-	} else if (shift < 1.0) {
-		float z = (shift - 0.66) / 0.334;
-		r = mix(previous.g, previous.r, z);
-		g = mix(previous.b, previous.g, z);
-		b = mix(current.r,  previous.b, z);
-	}
-
-	float t = max(max(r,g),b);
-	vec4 color = vec4(front_color.rgb, (r+g+b)/3.0);
-	color = t*color + (1.0-t)*vec4(r,g,b, min(min(r,g),b));
-	frag_color = vec4( color.rgb, front_color.a*color.a);
+	frag_color = front_color * texture(tex, uv).r;
 }
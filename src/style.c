@@ -50,6 +50,42 @@ static const struct rtb_style_property_definition fallbacks[RTB_STYLE_PROP_TYPE_
 	}
 };
 
+/* what css2c calls the builtin property IDs. only used for styles that
+ * didn't come out of css2c. */
+static const char *const builtin_prop_names[RTB_STYLE_BUILTIN_PROPS] = {
+	[RTB_STYLE_PROP_ID_COLOR]            = "color",
+	[RTB_STYLE_PROP_ID_BACKGROUND_COLOR] = "background-color",
+	[RTB_STYLE_PROP_ID_BACKGROUND_IMAGE] = "background-image",
+	[RTB_STYLE_PROP_ID_BORDER_IMAGE]     = "border-image",
+	[RTB_STYLE_PROP_ID_BORDER_COLOR]     = "border-color",
+	[RTB_STYLE_PROP_ID_MIN_WIDTH]        = "min-width",
+	[RTB_STYLE_PROP_ID_MIN_HEIGHT]       = "min-height",
+	[RTB_STYLE_PROP_ID_FONT]             = "font",
+	[RTB_STYLE_PROP_ID_KNOB_ROTOR]       = "-rtb-knob-rotor",
+
+	[RTB_STYLE_PROP_ID_TRANSITION_DURATION] = "transition-duration",
+	[RTB_STYLE_PROP_ID_TRANSITION_TIMING_FUNCTION] =
+		"transition-timing-function"
+};
+
+static const rtb_style_prop_type_t builtin_prop_types[RTB_STYLE_BUILTIN_PROPS] = {
+	[RTB_STYLE_PROP_ID_COLOR]            = RTB_STYLE_PROP_COLOR,
+	[RTB_STYLE_PROP_ID_BACKGROUND_COLOR] = RTB_STYLE_PROP_COLOR,
+	[RTB_STYLE_PROP_ID_BACKGROUND_IMAGE] = RTB_STYLE_PROP_TEXTURE,
+	[RTB_STYLE_PROP_ID_BORDER_IMAGE]     = RTB_STYLE_PROP_TEXTURE,
+	[RTB_STYLE_PROP_ID_BORDER_COLOR]     = RTB_STYLE_PROP_COLOR,
+	[RTB_STYLE_PROP_ID_MIN_WIDTH]        = RTB_STYLE_PROP_FLOAT,
+	[RTB_STYLE_PROP_ID_MIN_HEIGHT]       = RTB_STYLE_PROP_FLOAT,
+	[RTB_STYLE_PROP_ID_FONT]             = RTB_STYLE_PROP_FONT,
+	[RTB_STYLE_PROP_ID_KNOB_ROTOR]       = RTB_STYLE_PROP_TEXTURE,
+
+	[RTB_STYLE_PROP_ID_TRANSITION_DURATION] = RTB_STYLE_PROP_FLOAT,
+	[RTB_STYLE_PROP_ID_TRANSITION_TIMING_FUNCTION] = RTB_STYLE_PROP_INT
+};
+
+#define INHERITED(id) \
+	((id) == RTB_STYLE_PROP_ID_COLOR || (id) == RTB_STYLE_PROP_ID_FONT)
+
 static rtb_draw_state_t
 draw_state_for_elem_state(unsigned int state)
 {
@@ -92,11 +128,68 @@ load_font_face(const struct rtb_style_font_face *face)
 	return 0;
 }
 
+static struct rtb_font *
+font_for_def(struct rtb_window *window,
+		const struct rtb_style_font_definition *def)
+{
+	return &window->style_fonts[def->slot];
+}
+
+static int
+load_font(struct rtb_window *window,
+		const struct rtb_style_font_definition *def, int async)
+{
+	const struct rtb_style_font_face *const *fallback;
+	struct rtb_font *font = font_for_def(window, def);
+	int err;
+
+	if (font->load_failed)
+		return -1;
+
+	if (load_font_face(def->face))
+		goto err_load;
+
+	font->lcd_gamma = def->lcd_gamma;
+	font->antialias = def->antialias;
+
+	if (async)
+		err = rtb_font_manager_prefetch_embedded_font(&window->font_manager,
+				font, def->size,
+				def->face->buffer.data, def->face->buffer.size);
+	else
+		err = rtb_font_manager_load_embedded_font(&window->font_manager,
+				font, def->size,
+				def->face->buffer.data, def->face->buffer.size);
+
+	if (err) {
+		font->txfont = NULL;
+		goto err_load;
+	}
+
+	if (!def->fallbacks)
+		return 0;
+
+	/* a fallback we can't load isn't worth failing the style over */
+	for (fallback = def->fallbacks; *fallback; fallback++) {
+		if (load_font_face(*fallback))
+			continue;
+
+		rtb_font_manager_add_embedded_fallback(&window->font_manager,
+				font, (*fallback)->buffer.data,
+				(*fallback)->buffer.size);
+	}
+
+	return 0;
+
+err_load:
+	font->load_failed = 1;
+	return -1;
+}
+
 static int
 load_assets(struct rtb_window *window,
 		const struct rtb_style_property_definition *property)
 {
-	struct rtb_font *font;
 	int assets_loaded = 0;
 
 	for(; property->property_name; property++) {
@@ -109,18 +202,12 @@ load_assets(struct rtb_window *window,
 			break;
 
 		case RTB_STYLE_PROP_FONT:
+			/* the font itself isn't loaded until something asks
+			 * for it (see rtb_style_get_font_for_def() and
+			 * rtb_style_prefetch_fonts()) */
 			if (load_font_face(property->font.face))
 				return -1;
 
-			font = rtb_style_get_font_for_def(window, &property->font);
-			font->lcd_gamma = property->font.lcd_gamma;
-
-			if (rtb_font_manager_load_embedded_font(&window->font_manager,
-						font, property->font.size,
-						property->font.face->buffer.data,
-						property->font.face->buffer.size))
-				return -1;
-
 			assets_loaded++;
 			break;
 
@@ -132,32 +219,113 @@ load_assets(struct rtb_window *window,
 	return assets_loaded;
 }
 
+/**
+ * every window caches the style that applies to each type: the one
+ * written for the type itself or, failing that, for its nearest
+ * supertype. the cache is indexed by type id and kept per window, since
+ * type descriptors are shared between every window of a rutabaga.
+ * rtb_style_resolve_list() marks the types with styles of their own and
+ * the rest fill theirs in the first time they're asked for.
+ */
+
 static struct rtb_style *
-style_for_type(struct rtb_type_atom *atom, struct rtb_style *s)
+exact_style(struct rtb_type_atom_descriptor *type, struct rtb_style *s)
 {
-	for (; s->for_type; s++) {
-		if (s->resolved_type && rtb_is_type(s->resolved_type, atom)) {
+	for (; s->for_type; s++)
+		if (s->resolved_type == type)
 			return s;
-		}
-	}
 
 	return NULL;
 }
 
+static struct rtb_type_style *
+type_style_slot(struct rtb_window *win, struct rtb_type_atom_descriptor *type)
+{
+	struct rtb_type_style *styles;
+	unsigned size;
+
+	if (type->id < win->ntype_styles)
+		return &win->type_styles[type->id];
+
+	size = win->ntype_styles ? win->ntype_styles : 32;
+	while (size <= type->id)
+		size *= 2;
+
+	styles = realloc(win->type_styles, size * sizeof(*styles));
+	if (!styles)
+		return NULL;
+
+	memset(&styles[win->ntype_styles], 0,
+			(size - win->ntype_styles) * sizeof(*styles));
+
+	win->type_styles = styles;
+	win->ntype_styles = size;
+	return &styles[type->id];
+}
+
+static void
+invalidate_type_styles(struct rtb_window *win)
+{
+	if (++win->type_style_stamp)
+		return;
+
+	/* wrapped around, so stale entries could look current */
+	memset(win->type_styles, 0,
+			win->ntype_styles * sizeof(*win->type_styles));
+	win->type_style_stamp = 1;
+}
+
 static struct rtb_style *
-inherits_from(struct rtb_type_atom_descriptor *type,
+resolve_type(struct rtb_window *win, struct rtb_type_atom_descriptor *type,
 		struct rtb_style *style_list)
 {
-	struct rtb_type_atom_descriptor *super;
-
-	for (; style_list->for_type; style_list++) {
-		for (super = type->super[0]; super; super = super->super[0]) {
-			if (style_list->resolved_type == super)
-				return style_list;
-		}
+	struct rtb_type_style *slot;
+	struct rtb_style *style;
+
+	if (!type)
+		return NULL;
+
+	/* only the window's resolved list is cached. for that one, types
+	 * with a style of their own have already been marked, so the rest
+	 * only need to look at their supertypes. */
+	slot = NULL;
+	if (style_list == win->resolved_style_list)
+		slot = type_style_slot(win, type);
+
+	if (slot && slot->stamp == win->type_style_stamp)
+		return slot->style;
+
+	style = NULL;
+	if (!slot)
+		style = exact_style(type, style_list);
+	if (!style)
+		style = resolve_type(win, type->super[0], style_list);
+
+	if (slot) {
+		slot->stamp = win->type_style_stamp;
+		slot->style = style;
 	}
 
-	return NULL;
+	return style;
+}
+
+static struct rtb_style *
+style_for_type(struct rtb_window *win, struct rtb_type_atom *atom,
+		struct rtb_style *style_list)
+{
+	return resolve_type(win, atom->type, style_list);
+}
+
+static void
+mark_type_style(struct rtb_window *win, struct rtb_style *style)
+{
+	struct rtb_type_style *slot;
+
+	if (!(slot = type_style_slot(win, style->resolved_type)))
+		return;
+
+	slot->stamp = win->type_style_stamp;
+	slot->style = style;
 }
 
 static int
@@ -184,43 +352,69 @@ style_resolve(struct rtb_window *window, struct rtb_style *style)
  * queries
  */
 
+/**
+ * `id` is negative if the property isn't in the window's stylesheet, in
+ * which case only styles without an index (hand-written ones) can have
+ * it. `name` is only used for those.
+ */
+static const struct rtb_style_property_definition *
+lookup(const struct rtb_style *style, rtb_draw_state_t draw_state,
+		int id, const char *name, rtb_style_prop_type_t type)
+{
+	const struct rtb_style_property_definition *prop;
+	const uint8_t *index = style->prop_index[draw_state];
+
+	if (index) {
+		if (id < 0 || (size_t) id >= style->nprops || !index[id])
+			return NULL;
+
+		prop = &style->properties[draw_state][index[id] - 1];
+		return (prop->type == type) ? prop : NULL;
+	}
+
+	if (!name)
+		return NULL;
+
+	for (prop = style->properties[draw_state];
+			!!prop->property_name; prop++)
+		if (!strcmp(prop->property_name, name) && prop->type == type)
+			return prop;
+
+	return NULL;
+}
+
 static const struct rtb_style_property_definition *
 query_no_fallback(struct rtb_style *style_list, rtb_elem_state_t elem_state,
-		const char *property_name, rtb_style_prop_type_t type)
+		int id, const char *name, rtb_style_prop_type_t type)
 {
 	const struct rtb_style_property_definition *prop;
 	rtb_draw_state_t draw_state;
 
 	draw_state = draw_state_for_elem_state(elem_state);
 
-	for (; style_list; style_list = style_list->inherit_from) {
-		prop = style_list->properties[draw_state];
-
-		for (; !!prop->property_name; prop++)
-			if (!strcmp(prop->property_name, property_name)
-					&& prop->type == type)
-				return prop;
-	}
+	for (; style_list; style_list = style_list->inherit_from)
+		if ((prop = lookup(style_list, draw_state, id, name, type)))
+			return prop;
 
 	return NULL;
 }
 
 static const struct rtb_style_property_definition *
 query(struct rtb_style *style_list, rtb_elem_state_t elem_state,
-		const char *property_name, rtb_style_prop_type_t type,
+		int id, const char *name, rtb_style_prop_type_t type,
 		int return_fallback)
 {
 	const struct rtb_style_property_definition *prop;
 
 	if ((prop = query_no_fallback(style_list,
-					elem_state, property_name, type)))
+					elem_state, id, name, type)))
 		return prop;
 
 	switch (elem_state) {
 	case RTB_STATE_FOCUS_HOVER:
 	case RTB_STATE_FOCUS_ACTIVE:
 		if ((prop = query_no_fallback(style_list,
-						RTB_STATE_FOCUS, property_name, type)))
+						RTB_STATE_FOCUS, id, name, type)))
 			return prop;
 
 		/* fall-through */
@@ -229,7 +423,7 @@ query(struct rtb_style *style_list, rtb_elem_state_t elem_state,
 	case RTB_STATE_HOVER:
 	case RTB_STATE_ACTIVE:
 		if ((prop = query_no_fallback(style_list,
-						RTB_STATE_NORMAL, property_name, type)))
+						RTB_STATE_NORMAL, id, name, type)))
 			return prop;
 
 	default:
@@ -241,11 +435,109 @@ query(struct rtb_style *style_list, rtb_elem_state_t elem_state,
 	return NULL;
 }
 
+static const char *
+prop_name(struct rtb_window *win, rtb_style_prop_id_t id)
+{
+	if (win->style_prop_names)
+		return win->style_prop_names[id];
+
+	if (id < RTB_STYLE_BUILTIN_PROPS)
+		return builtin_prop_names[id];
+
+	return NULL;
+}
+
+int
+rtb_style_prop_id(struct rtb_window *win, const char *property_name)
+{
+	int i;
+
+	if (win->style_prop_names) {
+		for (i = 0; win->style_prop_names[i]; i++)
+			if (!strcmp(win->style_prop_names[i], property_name))
+				return i;
+
+		return -1;
+	}
+
+	for (i = 0; i < RTB_STYLE_BUILTIN_PROPS; i++)
+		if (!strcmp(builtin_prop_names[i], property_name))
+			return i;
+
+	return -1;
+}
+
+const struct rtb_style_property_definition *rtb_style_query_prop_by_id(
+		struct rtb_element *elem, rtb_style_prop_id_t id,
+		rtb_style_prop_type_t type, int should_return_fallback)
+{
+	return query(elem->style, elem->state, id, prop_name(elem->window, id),
+			type, should_return_fallback);
+}
+
+const struct rtb_style_property_definition *rtb_style_query_prop_in_tree_by_id(
+		struct rtb_element *leaf, rtb_style_prop_id_t id,
+		rtb_style_prop_type_t type, int should_return_fallback)
+{
+	const struct rtb_style_property_definition *prop;
+	const char *name = prop_name(leaf->window, id);
+
+	for (prop = NULL; !prop && leaf->parent != leaf; leaf = leaf->parent)
+		prop = query(leaf->style, leaf->state, id, name,
+				type, should_return_fallback);
+
+	return prop;
+}
+
+/**
+ * computed style
+ */
+
+void
+rtb_style_compute(struct rtb_element *elem)
+{
+	const struct rtb_style_property_definition *prop;
+	const struct rtb_computed_style *inherit;
+	rtb_style_prop_id_t id;
+
+	/* the window is its own parent */
+	inherit = (elem->parent && elem->parent != elem)
+		? &elem->parent->computed : NULL;
+
+	for (id = 0; id < RTB_STYLE_BUILTIN_PROPS; id++) {
+		prop = query(elem->style, elem->state, id,
+				prop_name(elem->window, id), builtin_prop_types[id], 0);
+
+		if (!prop && inherit && INHERITED(id))
+			prop = inherit->props[id];
+
+		elem->computed.props[id] = prop;
+	}
+}
+
+const struct rtb_style_property_definition *
+rtb_style_computed_prop(const struct rtb_element *elem,
+		rtb_style_prop_id_t id, int should_return_fallback)
+{
+	const struct rtb_style_property_definition *prop;
+
+	if ((prop = elem->computed.props[id]) || !should_return_fallback)
+		return prop;
+
+	return &fallbacks[builtin_prop_types[id]];
+}
+
+/**
+ * the string API looks the name up once, and then goes by ID like
+ * everything else.
+ */
+
 const struct rtb_style_property_definition *rtb_style_query_prop(
 		struct rtb_element *elem, const char *property_name,
 		rtb_style_prop_type_t type, int should_return_fallback)
 {
 	return query(elem->style, elem->state,
+			rtb_style_prop_id(elem->window, property_name),
 			property_name, type, should_return_fallback);
 }
 
@@ -254,10 +546,11 @@ const struct rtb_style_property_definition *rtb_style_query_prop_in_tree(
 		rtb_style_prop_type_t type, int should_return_fallback)
 {
 	const struct rtb_style_property_definition *prop;
+	int id = rtb_style_prop_id(leaf->window, property_name);
 
 	for (prop = NULL; !prop && leaf->parent != leaf; leaf = leaf->parent)
-		prop = query(leaf->style, leaf->state,
-				property_name, type, should_return_fallback);
+		prop = query(leaf->style, leaf->state, id, property_name,
+				type, should_return_fallback);
 
 	return prop;
 }
@@ -281,10 +574,20 @@ rtb_style_elem_has_properties_for_state(struct rtb_element *elem,
 int
 rtb_style_resolve_list(struct rtb_window *win, struct rtb_style *style_list)
 {
-	int i, unresolved_styles;
+	int i, unresolved_styles, newly_resolved;
 	struct rtb_style *s;
 
+	/* this runs every time an element is attached. a style can only
+	 * start resolving once its type exists, so if no types have been
+	 * created since last time, there's nothing to do. types created in
+	 * the meantime without a style of their own get theirs from
+	 * style_for_type() the first time they're asked. */
+	if (win->resolved_style_list == style_list
+			&& win->resolved_type_generation == win->rtb->atoms.generation)
+		return win->unresolved_styles;
+
 	unresolved_styles = 0;
+	newly_resolved = 0;
 
 	for (i = 0; style_list[i].for_type; i++) {
 		s = &style_list[i];
@@ -294,15 +597,41 @@ rtb_style_resolve_list(struct rtb_window *win, struct rtb_style *style_list)
 
 		if (style_resolve(win, s))
 			unresolved_styles++;
+		else
+			newly_resolved++;
+	}
+
+	win->unresolved_styles = unresolved_styles;
+	win->resolved_type_generation = win->rtb->atoms.generation;
+
+	/* the types already cached still point at the right styles unless
+	 * one of them (or one of their supertypes) just got its own. */
+	if (win->resolved_style_list == style_list && !newly_resolved)
+		return unresolved_styles;
+
+	win->resolved_style_list = style_list;
+
+	/* mark the types that have styles of their own, walking backwards
+	 * so that the first style listed for a type wins. everything else
+	 * inherits from its nearest marked supertype, which resolve_type()
+	 * fills in the first time the type is asked for. */
+	invalidate_type_styles(win);
+
+	while (i--) {
+		s = &style_list[i];
+
+		if (s->resolved_type)
+			mark_type_style(win, s);
 	}
 
 	for (i = 0; style_list[i].for_type; i++) {
 		s = &style_list[i];
 
-		if (!s->resolved_type || s->inherit_from)
+		if (!s->resolved_type)
 			continue;
 
-		s->inherit_from = inherits_from(s->resolved_type, style_list);
+		s->inherit_from = resolve_type(win,
+				s->resolved_type->super[0], style_list);
 	}
 
 	return unresolved_styles;
@@ -314,7 +643,8 @@ rtb_style_apply_to_tree(struct rtb_element *root, struct rtb_style *style_list)
 	struct rtb_element *iter;
 
 	if (!root->style)
-		root->style = style_for_type(RTB_TYPE_ATOM(root), style_list);
+		root->style = style_for_type(root->window,
+				RTB_TYPE_ATOM(root), style_list);
 
 	TAILQ_FOREACH(iter, &root->children, child)
 		rtb_style_apply_to_tree(iter, style_list);
@@ -323,14 +653,48 @@ rtb_style_apply_to_tree(struct rtb_element *root, struct rtb_style *style_list)
 struct rtb_style *
 rtb_style_for_element(struct rtb_element *elem, struct rtb_style *style_list)
 {
-	return style_for_type(RTB_TYPE_ATOM(elem), style_list);
+	return style_for_type(elem->window, RTB_TYPE_ATOM(elem), style_list);
 }
 
 struct rtb_font *
 rtb_style_get_font_for_def(struct rtb_window *win,
 		const struct rtb_style_font_definition *def)
 {
-	return &win->style_fonts[def->slot];
+	struct rtb_font *font = font_for_def(win, def);
+
+	if (!font->txfont && !font->load_failed)
+		load_font(win, def, 0);
+
+	return font;
+}
+
+/**
+ * kicks off background loading for every font that the elements under
+ * `root` will ask for in their current state, so that they rasterise in
+ * parallel rather than one after another as each element restyles.
+ */
+void
+rtb_style_prefetch_fonts(struct rtb_element *root)
+{
+	const struct rtb_style_property_definition *prop;
+	struct rtb_window *win = root->window;
+	struct rtb_element *iter;
+	struct rtb_style *style;
+
+	style = root->style;
+	if (!style)
+		style = style_for_type(win, RTB_TYPE_ATOM(root), win->style_list);
+
+	if (style) {
+		prop = query(style, root->state, RTB_STYLE_PROP_ID_FONT, "font",
+				RTB_STYLE_PROP_FONT, 0);
+
+		if (prop && !font_for_def(win, &prop->font)->txfont)
+			load_font(win, &prop->font, 1);
+	}
+
+	TAILQ_FOREACH(iter, &root->children, child)
+		rtb_style_prefetch_fonts(iter);
 }
 
 struct rtb_style_data
@@ -341,6 +705,7 @@ rtb_style_get_defaults(void)
 
 	return (struct rtb_style_data) {
 		.style = stlist,
-		.nfonts	= default_style_fonts
+		.nfonts	= default_style_fonts,
+		.prop_names = default_style_props
 	};
 }
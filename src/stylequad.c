@@ -25,6 +25,7 @@
  */
 
 #include <rutabaga/rutabaga.h>
+#include <rutabaga/animation.h>
 #include <rutabaga/element.h>
 #include <rutabaga/render.h>
 #include <rutabaga/style.h>
@@ -156,8 +157,15 @@ rtb_stylequad_draw_on_element(struct rtb_stylequad *self,
 {
 	struct rtb_shader *shader = &on->window->local_storage.shader.stylequad;
 	struct rtb_render_context *ctx = rtb_render_get_context(on);
+	mat4 modelview;
 
 	rtb_render_reset(on, shader);
+
+	if (self->transform) {
+		rtb_transform_to_mat4(self->transform, &modelview);
+		rtb_render_set_modelview(ctx, modelview.data);
+	}
+
 	draw(ctx, self, &self->offset, mode);
 }
 
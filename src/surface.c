@@ -41,12 +41,33 @@
 #define SELF_FROM(elem) \
 	struct rtb_surface *self = RTB_ELEMENT_AS(elem, rtb_surface)
 
+#define NSEC_PER_SEC 1000000000ull
+
+/* frame timestamps jitter, and an element limited to half the frame rate
+ * that misses its frame by a hair would otherwise drop to a third. */
+#define REDRAW_RATE_SLACK 2000000ull
+
 /**
  * internal stuff
  */
 
 static struct rtb_element_implementation super;
 
+static int
+redraw_too_soon(const struct rtb_element *elem, uint64_t now)
+{
+	uint64_t interval;
+
+	if (!elem->queued_redraw_rate || !elem->last_drawn)
+		return 0;
+
+	interval = NSEC_PER_SEC / elem->queued_redraw_rate;
+	if (interval <= REDRAW_RATE_SLACK)
+		return 0;
+
+	return (now - elem->last_drawn) < (interval - REDRAW_RATE_SLACK);
+}
+
 /**
  * element implementation
  */
@@ -66,6 +87,7 @@ reflow(struct rtb_element *elem, struct rtb_element *instigator,
 {
 	struct rtb_phy_size phy_size;
 	struct rtb_rect phy_rect;
+	GLint bound_fb;
 	struct rtb_rect tex_coords = {
 		.as_float = {
 			0.f, 1.f,
@@ -110,10 +132,14 @@ reflow(struct rtb_element *elem, struct rtb_element *instigator,
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glBindTexture(GL_TEXTURE_2D, 0);
 
+	/* we can reflow partway through a frame, and the frame may not be
+	 * going to framebuffer 0 (see the x11 render thread), so put back
+	 * whatever was bound. */
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound_fb);
 	glBindFramebuffer(GL_FRAMEBUFFER, self->fbo);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
 			GL_TEXTURE_2D, self->texture, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, bound_fb);
 
 	phy_rect = self->rect;
 	phy_rect.size.w *= self->window->scale.x;
@@ -142,7 +168,7 @@ attached(struct rtb_element *self,
 		struct rtb_element *parent, struct rtb_window *window)
 {
 	super.attached(self, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.surface");
 }
 
@@ -203,6 +229,8 @@ void
 rtb_surface_draw_children(struct rtb_surface *self)
 {
 	struct rtb_element *iter;
+	uint64_t now = self->window->frame_time;
+	int deferred = 0;
 
 	GLint bound_fb;
 	GLint viewport[4];
@@ -253,15 +281,31 @@ rtb_surface_draw_children(struct rtb_surface *self)
 		while ((iter = TAILQ_FIRST(&self->render_queue))) {
 			TAILQ_REMOVE(&self->render_queue, iter, render_entry);
 
+			/* elements with a max_redraw_rate wait for the first frame
+			 * they're allowed to draw on. they stay marked dirty in the
+			 * meantime, so marking them again doesn't queue them twice. */
+			if (redraw_too_soon(iter, now)) {
+				TAILQ_INSERT_TAIL(&self->next_frame_render_queue,
+						iter, render_entry);
+				deferred = 1;
+				continue;
+			}
+
 			iter->render_entry.tqe_next = NULL;
 			iter->render_entry.tqe_prev = NULL;
 
+			iter->last_drawn = now;
 			rtb_elem_draw(iter, 1);
 		}
 
 		break;
 	}
 
+	/* while we're still in_redraw, so that we go onto our own surface's
+	 * queue for next frame. */
+	if (deferred)
+		rtb_elem_mark_dirty(RTB_ELEMENT(self));
+
 	self->in_redraw = 0;
 
 	// if any elements requested a redraw *from* their draw func, they'll
@@ -0,0 +1,164 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <rutabaga/rutabaga.h>
+#include <rutabaga/font-manager.h>
+
+#include "rtb_private/font-coverage.h"
+
+static int
+open_face(const struct rtb_texture_font *txfont,
+		FT_Library *library, FT_Face *face)
+{
+	FT_Error err;
+
+	if (FT_Init_FreeType(library))
+		return -1;
+
+	switch (txfont->loaded_from) {
+	case RTB_FONT_EMBEDDED:
+		err = FT_New_Memory_Face(*library, txfont->location.mem.base,
+				txfont->location.mem.size, 0, face);
+		break;
+
+	case RTB_FONT_EXTERNAL:
+		err = FT_New_Face(*library, txfont->location.path, 0, face);
+		break;
+
+	default:
+		err = 1;
+		break;
+	}
+
+	if (err || FT_Select_Charmap(*face, FT_ENCODING_UNICODE))
+		goto err_face;
+
+	return 0;
+
+err_face:
+	if (!err)
+		FT_Done_Face(*face);
+	FT_Done_FreeType(*library);
+	return -1;
+}
+
+/**
+ * private API
+ */
+
+struct rtb_font_coverage *
+rtb__font_coverage_build(const struct rtb_texture_font *txfont)
+{
+	uint16_t pages[RTB_FONT_COVERAGE_PAGES];
+	struct rtb_font_coverage *cov;
+	FT_Library library;
+	FT_ULong c;
+	FT_UInt gid;
+	FT_Face face;
+	uint32_t *block;
+	unsigned nblocks;
+
+	if (open_face(txfont, &library, &face))
+		return NULL;
+
+	/* first pass over the cmap to find out how many pages are in use.
+	 * block 0 is the empty block. */
+	memset(pages, 0, sizeof(pages));
+	nblocks = 1;
+
+	for (c = FT_Get_First_Char(face, &gid); gid;
+			c = FT_Get_Next_Char(face, c, &gid)) {
+		if (c >= RTB_FONT_COVERAGE_LIMIT)
+			break;
+
+		if (!pages[c >> 8])
+			pages[c >> 8] = nblocks++;
+	}
+
+	cov = calloc(1, sizeof(*cov) + (nblocks * sizeof(*cov->blocks)));
+	if (!cov)
+		goto out;
+
+	cov->magic = RTB_FONT_COVERAGE_MAGIC;
+	cov->nblocks = nblocks;
+	memcpy(cov->pages, pages, sizeof(pages));
+
+	for (c = FT_Get_First_Char(face, &gid); gid;
+			c = FT_Get_Next_Char(face, c, &gid)) {
+		if (c >= RTB_FONT_COVERAGE_LIMIT)
+			break;
+
+		block = cov->blocks[pages[c >> 8]];
+		block[(c >> 5) & 7] |= 1u << (c & 31);
+	}
+
+out:
+	FT_Done_Face(face);
+	FT_Done_FreeType(library);
+	return cov;
+}
+
+const struct rtb_font_coverage *
+rtb__font_coverage_from_buffer(const void *buf, size_t size)
+{
+	const struct rtb_font_coverage *cov = buf;
+	unsigned i;
+
+	if (!buf || ((uintptr_t) buf % __alignof__(*cov))
+			|| size < sizeof(*cov))
+		return NULL;
+
+	if (cov->magic != RTB_FONT_COVERAGE_MAGIC || !cov->nblocks
+			|| size != rtb_font_coverage_size(cov))
+		return NULL;
+
+	/* don't trust anything we read off the disk to stay in bounds */
+	for (i = 0; i < RTB_FONT_COVERAGE_PAGES; i++)
+		if (cov->pages[i] >= cov->nblocks)
+			return NULL;
+
+	for (i = 0; i < 8; i++)
+		if (cov->blocks[0][i])
+			return NULL;
+
+	return cov;
+}
+
+/**
+ * public API
+ */
+
+size_t
+rtb_font_coverage_size(const struct rtb_font_coverage *cov)
+{
+	return sizeof(*cov) + (cov->nblocks * sizeof(*cov->blocks));
+}
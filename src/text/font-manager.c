@@ -33,6 +33,14 @@
 #include <rutabaga/shader.h>
 
 #include "shaders/text.glsl.h"
+#include "shaders/text-lcd.glsl.h"
+#include "shaders/text-lcd-subpixel.glsl.h"
+
+#include "rtb_private/stdlib-allocator.h"
+
+#include "rtb_private/shaper.h"
+#include "rtb_private/font-coverage.h"
+#include "rtb_private/glyph-cache.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -59,29 +67,257 @@ static const rtb_utf32_t default_cache[] = {
 	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '*', '+', '-', '/', ':', '<', '=', '>', '`', 0
 };
 
+/**
+ * background rasterisation
+ *
+ * FreeType runs on the libuv threadpool and leaves its bitmaps in a
+ * staging buffer. anything that touches the atlas or the font's glyph
+ * list (which is everything else) happens back on the GL thread, either
+ * from the after-work callback or from whoever needs the font first.
+ */
+
+struct staged_glyph {
+	texture_glyph_t metrics;
+	size_t offset;
+};
+
+struct rtb_font_job {
+	uv_work_t req;
+	uv_sem_t done;
+
+	struct rtb_texture_font *txfont;
+	rtb_utf32_t *charcodes;
+
+	VECTOR(staged_glyphs, struct staged_glyph) glyphs;
+	VECTOR(staged_pixels, uint8_t) pixels;
+
+	/* set once the GL thread has taken (or thrown away) the results.
+	 * the job itself is only freed from the after-work callback. */
+	int finished;
+
+	LIST_ENTRY(rtb_font_job) entry;
+};
+
+static int
+stage_glyph(void *ctx, const texture_glyph_t *metrics,
+		const unsigned char *bitmap, size_t stride)
+{
+	struct rtb_font_job *job = ctx;
+	struct staged_glyph staged;
+	size_t row, row_size;
+
+	row_size = metrics->width * job->txfont->txfont->atlas->depth;
+
+	staged.metrics = *metrics;
+	staged.offset  = job->pixels.size;
+
+	for (row = 0; row < metrics->height; row++)
+		VECTOR_PUSH_BACK_DATA(&job->pixels, bitmap + (row * stride), row_size);
+
+	VECTOR_PUSH_BACK(&job->glyphs, &staged);
+	return 0;
+}
+
+static void
+rasterise_work(uv_work_t *req)
+{
+	struct rtb_font_job *job = req->data;
+
+	texture_font_render_glyphs(job->txfont->txfont, job->charcodes,
+			stage_glyph, job);
+
+	uv_sem_post(&job->done);
+}
+
+static void
+finish_job(struct rtb_font_job *job, int keep_results)
+{
+	struct rtb_texture_font *txfont = job->txfont;
+	texture_font_t *font = txfont->txfont;
+	struct staged_glyph *staged;
+	size_t i, stride;
+
+	LIST_REMOVE(job, entry);
+
+	txfont->pending = NULL;
+	job->finished = 1;
+
+	if (!keep_results)
+		return;
+
+	stride = font->atlas->depth;
+
+	for (i = 0; i < job->glyphs.size; i++) {
+		staged = &job->glyphs.data[i];
+
+		/* something may have rendered it synchronously while the job
+		 * was running. */
+		if (texture_font_find_glyph(font, staged->metrics.charcode))
+			continue;
+
+		texture_font_add_glyph(font, &staged->metrics,
+				job->pixels.data + staged->offset,
+				staged->metrics.width * stride);
+	}
+
+	texture_font_generate_kerning(font);
+	rtb__glyph_cache_save(txfont);
+}
+
+static void
+free_job(struct rtb_font_job *job)
+{
+	VECTOR_FREE(&job->glyphs);
+	VECTOR_FREE(&job->pixels);
+	uv_sem_destroy(&job->done);
+	free(job->charcodes);
+	free(job);
+}
+
+static void
+rasterise_after_work(uv_work_t *req, int status)
+{
+	struct rtb_font_job *job = req->data;
+
+	if (!job->finished)
+		finish_job(job, 1);
+
+	free_job(job);
+}
+
+/**
+ * blocks until `txfont`'s background rasterisation (if any) is done.
+ */
+static void
+wait_for_txfont(struct rtb_texture_font *txfont, int keep_results)
+{
+	struct rtb_font_job *job = txfont->pending;
+
+	if (!job)
+		return;
+
+	uv_sem_wait(&job->done);
+	finish_job(job, keep_results);
+}
+
 static int
-init_txfont(struct rtb_texture_font *txfont, const rtb_utf32_t *cache)
+queue_rasterise(struct rtb_font_manager *fm, struct rtb_texture_font *txfont,
+		rtb_utf32_t *charcodes, size_t n)
 {
+	struct rtb_font_job *job;
+	size_t pixels_guess;
+
+	if (!(job = calloc(1, sizeof(*job))))
+		goto err_calloc;
+
+	if (uv_sem_init(&job->done, 0))
+		goto err_sem;
+
+	job->txfont    = txfont;
+	job->charcodes = charcodes;
+	job->req.data  = job;
+
+	/* roughly a 16x16 bitmap per glyph */
+	pixels_guess = n * 256 * txfont->txfont->atlas->depth;
+
+	VECTOR_INIT(&job->glyphs, &stdlib_allocator, n);
+	VECTOR_INIT(&job->pixels, &stdlib_allocator, pixels_guess);
+
+	if (uv_queue_work(fm->loop, &job->req,
+				rasterise_work, rasterise_after_work))
+		goto err_queue;
+
+	txfont->pending = job;
+	LIST_INSERT_HEAD(&fm->pending_jobs, job, entry);
+	return 0;
+
+err_queue:
+	VECTOR_FREE(&job->glyphs);
+	VECTOR_FREE(&job->pixels);
+	uv_sem_destroy(&job->done);
+err_sem:
+	free(job);
+err_calloc:
+	return -1;
+}
+
+static int
+init_txfont(struct rtb_font_manager *fm, struct rtb_texture_font *txfont,
+		int async)
+{
+	const rtb_utf32_t *cache = fm->cache_glyphs;
+	texture_font_t *font = txfont->txfont;
+	rtb_utf32_t *missing;
+	size_t i, n;
+
 	if (0)
-		memcpy(txfont->txfont->lcd_weights, lcd_weights, sizeof(lcd_weights));
+		memcpy(font->lcd_weights, lcd_weights, sizeof(lcd_weights));
+
+	if (!cache)
+		cache = default_cache;
+
+	txfont->pending = NULL;
+	txfont->cached_glyphs = 0;
+	rtb__glyph_cache_load(txfont);
+
+	/* only go to FreeType for what the disk cache didn't have */
+	for (n = 0; cache[n]; n++);
 
-	texture_font_load_glyphs(txfont->txfont, cache ? cache : default_cache);
+	if (!(missing = malloc((n + 1) * sizeof(*missing))))
+		return -1;
+
+	for (i = n = 0; cache[i]; i++)
+		if (!texture_font_find_glyph(font, cache[i]))
+			missing[n++] = cache[i];
+
+	missing[n] = 0;
+
+	if (!n) {
+		free(missing);
+		return 0;
+	}
+
+	/* the job owns `missing` from here on */
+	if (async && fm->loop && !queue_rasterise(fm, txfont, missing, n))
+		return 0;
+
+	texture_font_load_glyphs(font, missing);
+	rtb__glyph_cache_save(txfont);
+
+	free(missing);
 	return 0;
 }
 
+/**
+ * glyphs loaded on demand after the font was created don't make it into
+ * the disk cache until we get here.
+ */
+static void
+flush_glyph_cache(struct rtb_texture_font *txfont)
+{
+	if (vector_size(txfont->txfont->glyphs) > txfont->cached_glyphs)
+		rtb__glyph_cache_save(txfont);
+}
+
 /**
  * txfont refcounting
  */
 
 static int
-rtb_texture_font_unref(struct rtb_texture_font *f)
+rtb_texture_font_unref(struct rtb_font_manager *fm,
+		struct rtb_texture_font *f)
 {
 	unsigned rc = --f->refcount;
 
 	if (!rc) {
+		wait_for_txfont(f, 0);
+		flush_glyph_cache(f);
+		rtb__shaper_forget_font(fm, f);
+
 		if (f->loaded_from == RTB_FONT_EXTERNAL)
 			free(f->location.path);
 
+		free(f->built_coverage);
 		texture_font_delete(f->txfont);
 		free(f);
 	}
@@ -89,72 +325,175 @@ rtb_texture_font_unref(struct rtb_texture_font *f)
 	return rc;
 }
 
+/**
+ * atlases
+ */
+
+static texture_atlas_t *
+atlas_for(struct rtb_font_manager *fm, rtb_font_antialias_t antialias)
+{
+	size_t depth;
+
+	if (antialias == RTB_FONT_ANTIALIAS_LCD && !fm->lcd_supported)
+		antialias = RTB_FONT_ANTIALIAS_GRAYSCALE;
+
+	if (fm->atlases[antialias])
+		return fm->atlases[antialias];
+
+	depth = (antialias == RTB_FONT_ANTIALIAS_LCD) ? 3 : 1;
+
+	fm->atlases[antialias] = texture_atlas_new(1024, 1024,
+			depth, fm->dpi.x, fm->dpi.y);
+
+	return fm->atlases[antialias];
+}
+
 /**
  * emebedded font
  */
 
 static struct rtb_texture_font *
 find_duplicate_embedded_txfont(const struct rtb_font_manager *fm,
-		int pt_size, const void *base)
+		const struct rtb_font *like, const void *base)
 {
-	struct rtb_font *font;
+	struct rtb_font *font, *f;
 
 	TAILQ_FOREACH(font, &fm->managed_fonts, manager_entry) {
-		if (font->size == pt_size
-			&& font->txfont->loaded_from == RTB_FONT_EMBEDDED
-			&& font->txfont->location.mem.base == base)
-			return font->txfont;
+		for (f = font; f; f = f->fallback) {
+			if (f->size == like->size
+				&& f->lcd_gamma == like->lcd_gamma
+				&& f->antialias == like->antialias
+				&& f->txfont->loaded_from == RTB_FONT_EMBEDDED
+				&& f->txfont->location.mem.base == base)
+				return f->txfont;
+		}
 	}
 
 	return NULL;
 }
 
-int
-rtb_font_manager_load_embedded_font(struct rtb_font_manager *fm,
-		struct rtb_font *font, int pt_size, const void *base, size_t size)
+/**
+ * any size of the face at `base` that's already been hashed for the
+ * glyph cache saves hashing it again.
+ */
+static uint64_t
+embedded_face_hash(const struct rtb_font_manager *fm, const void *base)
 {
-	struct rtb_texture_font *txfont;
+	struct rtb_font *font, *f;
 
-	font->size   = pt_size;
-	font->fm     = fm;
+	TAILQ_FOREACH(font, &fm->managed_fonts, manager_entry) {
+		for (f = font; f; f = f->fallback) {
+			if (f->txfont->loaded_from == RTB_FONT_EMBEDDED
+				&& f->txfont->location.mem.base == base
+				&& f->txfont->face_hash)
+				return f->txfont->face_hash;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * `font`'s size, gamma and antialiasing mode say what to load.
+ */
+static struct rtb_texture_font *
+embedded_txfont(struct rtb_font_manager *fm, const struct rtb_font *font,
+		const void *base, size_t size, int async)
+{
+	struct rtb_texture_font *txfont;
+	texture_atlas_t *atlas;
 
-	if ((txfont = find_duplicate_embedded_txfont(fm, pt_size, base))) {
+	if ((txfont = find_duplicate_embedded_txfont(fm, font, base))) {
 		txfont->refcount++;
-	} else {
-		txfont = calloc(1, sizeof(*txfont));
-		if (!txfont)
-			goto err_calloc;
+		return txfont;
+	}
 
-		txfont->txfont = texture_font_new_from_memory(
-				fm->atlas, pt_size, base, size);
+	if (!(atlas = atlas_for(fm, font->antialias)))
+		goto err_calloc;
 
-		if (!txfont->txfont)
-			goto err_txfont_new;
+	txfont = calloc(1, sizeof(*txfont));
+	if (!txfont)
+		goto err_calloc;
 
-		init_txfont(txfont, fm->cache_glyphs);
-		txfont->refcount = 1;
+	txfont->txfont = texture_font_new_from_memory(
+			atlas, font->size, base, size);
 
-		txfont->loaded_from       = RTB_FONT_EMBEDDED;
-		txfont->location.mem.base = base;
-		txfont->location.mem.size = size;
-	}
+	if (!txfont->txfont)
+		goto err_txfont_new;
 
-	font->txfont = txfont;
+	txfont->txfont->gamma = font->lcd_gamma;
+	txfont->face_hash = embedded_face_hash(fm, base);
+	init_txfont(fm, txfont, async);
+	txfont->refcount = 1;
 
-	TAILQ_INSERT_TAIL(&fm->managed_fonts, font, manager_entry);
-	return 0;
+	txfont->loaded_from       = RTB_FONT_EMBEDDED;
+	txfont->location.mem.base = base;
+	txfont->location.mem.size = size;
+
+	return txfont;
 
 err_txfont_new:
 	free(txfont);
 err_calloc:
-	return -1;
+	return NULL;
+}
+
+static int
+load_embedded_font(struct rtb_font_manager *fm, struct rtb_font *font,
+		int pt_size, const void *base, size_t size, int async)
+{
+	font->size     = pt_size;
+	font->fm       = fm;
+	font->fallback = NULL;
+
+	if (!(font->txfont = embedded_txfont(fm, font, base, size, async)))
+		return -1;
+
+	TAILQ_INSERT_TAIL(&fm->managed_fonts, font, manager_entry);
+	return 0;
+}
+
+int
+rtb_font_manager_load_embedded_font(struct rtb_font_manager *fm,
+		struct rtb_font *font, int pt_size, const void *base, size_t size)
+{
+	return load_embedded_font(fm, font, pt_size, base, size, 0);
+}
+
+/**
+ * like rtb_font_manager_load_embedded_font(), but the glyphs that aren't
+ * in the disk cache are rasterised on the libuv threadpool. the font has
+ * to go through rtb_font_ready() before its glyphs are used.
+ */
+int
+rtb_font_manager_prefetch_embedded_font(struct rtb_font_manager *fm,
+		struct rtb_font *font, int pt_size, const void *base, size_t size)
+{
+	return load_embedded_font(fm, font, pt_size, base, size, 1);
+}
+
+static void
+free_fallbacks(struct rtb_font *font)
+{
+	struct rtb_font *fallback, *next;
+
+	for (fallback = font->fallback; fallback; fallback = next) {
+		next = fallback->fallback;
+
+		rtb_texture_font_unref(fallback->fm, fallback->txfont);
+		free(fallback);
+	}
+
+	font->fallback = NULL;
 }
 
 void
 rtb_font_manager_free_embedded_font(struct rtb_font *font)
 {
 	TAILQ_REMOVE(&font->fm->managed_fonts, font, manager_entry);
-	rtb_texture_font_unref(font->txfont);
+
+	free_fallbacks(font);
+	rtb_texture_font_unref(font->fm, font->txfont);
 
 	font->manager_entry.tqe_next = NULL;
 	font->manager_entry.tqe_prev = NULL;
@@ -166,12 +505,14 @@ rtb_font_manager_free_embedded_font(struct rtb_font *font)
 
 static struct rtb_texture_font *
 find_duplicate_external_txfont(const struct rtb_font_manager *fm,
-		int pt_size, const char *path)
+		const struct rtb_font *like, const char *path)
 {
 	struct rtb_font *font;
 
 	TAILQ_FOREACH(font, &fm->managed_fonts, manager_entry) {
-		if (font->size == pt_size
+		if (font->size == like->size
+			&& font->lcd_gamma == like->lcd_gamma
+			&& font->antialias == like->antialias
 			&& font->txfont->loaded_from == RTB_FONT_EXTERNAL
 			&& !strcmp(font->txfont->location.path, path))
 			return font->txfont;
@@ -180,29 +521,52 @@ find_duplicate_external_txfont(const struct rtb_font_manager *fm,
 	return NULL;
 }
 
+static uint64_t
+external_face_hash(const struct rtb_font_manager *fm, const char *path)
+{
+	struct rtb_font *font;
+
+	TAILQ_FOREACH(font, &fm->managed_fonts, manager_entry) {
+		if (font->txfont->loaded_from == RTB_FONT_EXTERNAL
+			&& !strcmp(font->txfont->location.path, path)
+			&& font->txfont->face_hash)
+			return font->txfont->face_hash;
+	}
+
+	return 0;
+}
+
 int
 rtb_font_manager_load_external_font(struct rtb_font_manager *fm,
 		struct rtb_external_font *font, int pt_size, const char *path)
 {
 	struct rtb_texture_font *txfont;
+	texture_atlas_t *atlas;
 
-	font->size = pt_size;
-	font->fm   = fm;
+	font->size     = pt_size;
+	font->fm       = fm;
+	font->fallback = NULL;
 
-	if ((txfont = find_duplicate_external_txfont(fm, pt_size, path))) {
+	if ((txfont = find_duplicate_external_txfont(fm,
+					RTB_FONT(font), path))) {
 		txfont->refcount++;
 	} else {
+		if (!(atlas = atlas_for(fm, font->antialias)))
+			goto err_calloc;
+
 		txfont = calloc(1, sizeof(*txfont));
 		if (!txfont)
 			goto err_calloc;
 
 		txfont->txfont = texture_font_new_from_file(
-				fm->atlas, pt_size, path);
+				atlas, pt_size, path);
 
 		if (!txfont->txfont)
 			goto err_txfont_new;
 
-		init_txfont(txfont, fm->cache_glyphs);
+		txfont->txfont->gamma = font->lcd_gamma;
+		txfont->face_hash = external_face_hash(fm, path);
+		init_txfont(fm, txfont, 0);
 		txfont->refcount = 1;
 
 		txfont->loaded_from   = RTB_FONT_EXTERNAL;
@@ -223,63 +587,251 @@ void
 rtb_font_manager_free_external_font(struct rtb_external_font *font)
 {
 	free(font->path);
-	rtb_texture_font_unref(font->txfont);
+
+	free_fallbacks(RTB_FONT(font));
+	rtb_texture_font_unref(font->fm, font->txfont);
+}
+
+/**
+ * fallbacks
+ */
+
+int
+rtb_font_manager_add_embedded_fallback(struct rtb_font_manager *fm,
+		struct rtb_font *font, const void *base, size_t size)
+{
+	struct rtb_font *fallback, **tail;
+
+	if (!(fallback = calloc(1, sizeof(*fallback))))
+		goto err_calloc;
+
+	fallback->size      = font->size;
+	fallback->lcd_gamma = font->lcd_gamma;
+	fallback->antialias = font->antialias;
+	fallback->fm        = fm;
+
+	/* fallbacks aren't needed until text actually uses them, so they
+	 * always rasterise in the background */
+	if (!(fallback->txfont = embedded_txfont(fm, fallback, base, size, 1)))
+		goto err_txfont;
+
+	for (tail = &font->fallback; *tail; tail = &(*tail)->fallback);
+	*tail = fallback;
+
+	return 0;
+
+err_txfont:
+	free(fallback);
+err_calloc:
+	return -1;
+}
+
+static const struct rtb_font_coverage *
+txfont_coverage(struct rtb_texture_font *txfont)
+{
+	if (!txfont->coverage)
+		txfont->coverage = txfont->built_coverage =
+			rtb__font_coverage_build(txfont);
+
+	return txfont->coverage;
+}
+
+/**
+ * walks the fallback chain for the first font that has `c`. if nobody
+ * has it, the font we started with gets to draw its .notdef glyph.
+ */
+const struct rtb_font *
+rtb_font_for_codepoint(const struct rtb_font *font, rtb_utf32_t c)
+{
+	const struct rtb_font_coverage *cov;
+	const struct rtb_font *f;
+
+	/* nothing to choose between, so don't bother reading the cmap */
+	if (!font->fallback)
+		return font;
+
+	for (f = font; f; f = f->fallback) {
+		/* if we couldn't read the cmap, assume the font has
+		 * everything rather than skipping it entirely */
+		if (!(cov = txfont_coverage(f->txfont))
+				|| rtb_font_coverage_has(cov, c)) {
+			rtb_font_ready(f);
+			return f;
+		}
+	}
+
+	return font;
+}
+
+/**
+ * fonts loaded with rtb_font_manager_prefetch_embedded_font() (and all
+ * fallbacks) might still be rasterising. this waits for that to finish
+ * and moves the results into the atlas.
+ */
+void
+rtb_font_ready(const struct rtb_font *font)
+{
+	wait_for_txfont(font->txfont, 1);
+}
+
+const struct rtb_font_coverage *
+rtb_font_get_coverage(const struct rtb_font *font)
+{
+	return txfont_coverage(font->txfont);
+}
+
+/**
+ * `buf` has to outlive the font. it isn't copied, so it can point
+ * straight into an mmap()ed file.
+ */
+int
+rtb_font_set_coverage(struct rtb_font *font, const void *buf, size_t size)
+{
+	struct rtb_texture_font *txfont = font->txfont;
+	const struct rtb_font_coverage *cov;
+
+	if (!(cov = rtb__font_coverage_from_buffer(buf, size)))
+		return -1;
+
+	free(txfont->built_coverage);
+	txfont->built_coverage = NULL;
+	txfont->coverage = cov;
+
+	return 0;
 }
 
 void
 rtb_font_manager_set_dpi(struct rtb_font_manager *fm, int dpi_x, int dpi_y)
 {
-	struct rtb_font *f;
+	struct rtb_font *font, *f;
+	rtb_font_antialias_t i;
+
+	/* the atlas is about to be cleared, and glyphs are read back out of
+	 * it to be saved */
+	TAILQ_FOREACH(font, &fm->managed_fonts, manager_entry) {
+		for (f = font; f; f = f->fallback) {
+			wait_for_txfont(f->txfont, 1);
+			flush_glyph_cache(f->txfont);
+		}
+	}
+
+	fm->dpi.x = dpi_x;
+	fm->dpi.y = dpi_y;
+
+	for (i = 0; i < RTB_FONT_ANTIALIAS_COUNT; i++) {
+		if (!fm->atlases[i])
+			continue;
 
-	texture_atlas_clear(fm->atlas);
+		texture_atlas_clear(fm->atlases[i]);
 
-	fm->atlas->dpi.x = dpi_x;
-	fm->atlas->dpi.y = dpi_y;
+		fm->atlases[i]->dpi.x = dpi_x;
+		fm->atlases[i]->dpi.y = dpi_y;
+	}
+
+	/* texture fonts can be shared between fonts, so they're all torn
+	 * down before any of them are reloaded. coverage doesn't depend on
+	 * the DPI, so that's kept. */
+	TAILQ_FOREACH(font, &fm->managed_fonts, manager_entry) {
+		for (f = font; f; f = f->fallback) {
+			if (!f->txfont->txfont)
+				continue;
 
-	TAILQ_FOREACH(f, &fm->managed_fonts, manager_entry) {
-		texture_font_delete(f->txfont->txfont);
-		f->txfont->txfont = texture_font_new_from_memory(
-			fm->atlas, f->size,
-			f->txfont->location.mem.base, f->txfont->location.mem.size);
+			rtb__shaper_forget_font(fm, f->txfont);
 
-		init_txfont(f->txfont, fm->cache_glyphs);
+			texture_font_delete(f->txfont->txfont);
+			f->txfont->txfont = NULL;
+		}
 	}
+
+	TAILQ_FOREACH(font, &fm->managed_fonts, manager_entry) {
+		for (f = font; f; f = f->fallback) {
+			if (f->txfont->txfont)
+				continue;
+
+			f->txfont->txfont = texture_font_new_from_memory(
+				atlas_for(fm, f->antialias), f->size,
+				f->txfont->location.mem.base,
+				f->txfont->location.mem.size);
+
+			if (!f->txfont->txfont)
+				continue;
+
+			f->txfont->txfont->gamma = f->lcd_gamma;
+			init_txfont(fm, f->txfont, 1);
+		}
+	}
+}
+
+static int
+shaders_init(struct rtb_font_manager *fm)
+{
+	static const char *fragment[RTB_TEXT_SHADER_COUNT] = {
+		[RTB_TEXT_SHADER_GRAYSCALE]    = TEXT_FRAG_SHADER,
+		[RTB_TEXT_SHADER_LCD]          = TEXT_LCD_FRAG_SHADER,
+		[RTB_TEXT_SHADER_LCD_SUBPIXEL] = TEXT_LCD_SUBPIXEL_FRAG_SHADER
+	};
+
+	struct rtb_font_shader *shader;
+	rtb_text_shader_t i;
+
+	for (i = 0; i < RTB_TEXT_SHADER_COUNT; i++) {
+		shader = &fm->shaders[i];
+
+		if (!rtb_shader_create(RTB_SHADER(shader),
+					TEXT_VERT_SHADER, NULL, fragment[i]))
+			goto err_shader;
+
+		shader->atlas_pixel =
+			glGetUniformLocation(shader->program, "atlas_pixel");
+	}
+
+	return 0;
+
+err_shader:
+	while (i--)
+		rtb_shader_free(RTB_SHADER(&fm->shaders[i]));
+
+	return -1;
+}
+
+static void
+shaders_fini(struct rtb_font_manager *fm)
+{
+	rtb_text_shader_t i;
+
+	for (i = 0; i < RTB_TEXT_SHADER_COUNT; i++)
+		rtb_shader_free(RTB_SHADER(&fm->shaders[i]));
 }
 
 int
 rtb_font_manager_init(struct rtb_font_manager *fm, int dpi_x, int dpi_y)
 {
-	if (!rtb_shader_create(RTB_SHADER(&fm->shader),
-				TEXT_VERT_SHADER, NULL, TEXT_FRAG_SHADER)) {
+	if (shaders_init(fm)) {
 		ERR("couldn't compile text shader.\n");
 		goto err_shader;
 	}
 
-#define CACHE_UNIFORM(UNIFORM) \
-	fm->shader.UNIFORM = glGetUniformLocation(fm->shader.program, #UNIFORM)
-
-	CACHE_UNIFORM(offset);
-	CACHE_UNIFORM(tex);
-	CACHE_UNIFORM(atlas_pixel);
-	CACHE_UNIFORM(gamma);
-
-#undef CACHE_UNIFORM
-
 	fm->cache_glyphs = NULL;
+	fm->loop = NULL;
+	LIST_INIT(&fm->pending_jobs);
 
 #if defined(FT_CONFIG_OPTION_SUBPIXEL_RENDERING) \
 	|| (FREETYPE_MAJOR > 2 \
 		|| (FREETYPE_MAJOR == 2 && (FREETYPE_MINOR > 8 \
 			|| (FREETYPE_MINOR == 8 && FREETYPE_PATCH >= 1))))
-# define TEXTURE_ATLAS_DEPTH 3
+	fm->lcd_supported = 1;
 #else
-# define TEXTURE_ATLAS_DEPTH 1
+	fm->lcd_supported = 0;
 #endif
 
-	fm->atlas = texture_atlas_new(1024, 1024,
-			TEXTURE_ATLAS_DEPTH, dpi_x, dpi_y);
+	/* atlases are made on demand by atlas_for() */
+	memset(fm->atlases, 0, sizeof(fm->atlases));
+
+	fm->dpi.x = dpi_x;
+	fm->dpi.y = dpi_y;
 
-#undef TEXTURE_ATLAS_DEPTH
+	/* shaping is optional, we can lay text out without it */
+	rtb__shaper_init(fm);
 
 	TAILQ_INIT(&fm->managed_fonts);
 	return 0;
@@ -292,11 +844,23 @@ void
 rtb_font_manager_fini(struct rtb_font_manager *fm)
 {
 	struct rtb_font *font;
+	rtb_font_antialias_t i;
 
-	TAILQ_FOREACH(font, &fm->managed_fonts, manager_entry)
-		rtb_texture_font_unref(font->txfont);
+	rtb__shaper_fini(fm);
+
+	/* jobs can't be cancelled once they're running, so all we can do is
+	 * wait them out. their after-work callbacks only free the job. */
+	while (!LIST_EMPTY(&fm->pending_jobs))
+		wait_for_txfont(LIST_FIRST(&fm->pending_jobs)->txfont, 0);
+
+	TAILQ_FOREACH(font, &fm->managed_fonts, manager_entry) {
+		free_fallbacks(font);
+		rtb_texture_font_unref(fm, font->txfont);
+	}
 
-	texture_atlas_delete(fm->atlas);
+	for (i = 0; i < RTB_FONT_ANTIALIAS_COUNT; i++)
+		if (fm->atlases[i])
+			texture_atlas_delete(fm->atlases[i]);
 
-	rtb_shader_free(RTB_SHADER(&fm->shader));
+	shaders_fini(fm);
 }
@@ -0,0 +1,533 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <rutabaga/rutabaga.h>
+#include <rutabaga/font-manager.h>
+
+#include "rtb_private/glyph-cache.h"
+
+#define CACHE_MAGIC   0x31434752 /* "RGC1" */
+#define CACHE_VERSION 2
+
+/**
+ * one file per (font, size, DPI, atlas depth, rasteriser settings), laid
+ * out as:
+ *
+ *     struct cache_header
+ *     struct cache_glyph    glyphs[nglyphs]
+ *     struct cache_kerning  kerning[nkerning]
+ *     uint8_t               bitmaps[bitmap_size]
+ *
+ * everything is in host byte order and 8-byte aligned, so the file can be
+ * mapped and read in place. each glyph's bitmap is `width * height` pixels
+ * of `depth` bytes with no padding between rows.
+ */
+
+struct cache_key {
+	uint64_t font_hash;
+
+	float size;
+	int32_t dpi_x, dpi_y;
+	uint32_t depth;
+
+	/* anything else that changes what FreeType gives us */
+	int32_t hinting;
+	int32_t filtering;
+	int32_t outline_type;
+	float outline_thickness;
+	float gamma;
+	uint8_t lcd_weights[8];
+};
+
+struct cache_header {
+	uint32_t magic;
+	uint32_t version;
+
+	struct cache_key key;
+
+	uint32_t nglyphs;
+	uint32_t nkerning;
+	uint64_t bitmap_size;
+};
+
+struct cache_glyph {
+	int32_t charcode;
+	uint32_t width, height;
+	int32_t offset_x, offset_y;
+	float advance_x, advance_y;
+
+	uint32_t kerning_start, nkerning;
+	uint32_t pad;
+
+	uint64_t bitmap_offset;
+};
+
+struct cache_kerning {
+	int32_t charcode;
+	float kerning;
+};
+
+/**
+ * keys and paths
+ */
+
+static uint64_t
+fnv1a64(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *p = data;
+
+	for (; size; size--, p++)
+		hash = (hash ^ *p) * 0x100000001b3ull;
+
+	return hash;
+}
+
+#define FNV_OFFSET 0xcbf29ce484222325ull
+
+static int
+hash_file(const char *path, uint64_t *hash)
+{
+	struct stat st;
+	void *map;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		goto err_open;
+
+	if (fstat(fd, &st) || st.st_size <= 0)
+		goto err_map;
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		goto err_map;
+
+	*hash = fnv1a64(*hash, map, st.st_size);
+
+	munmap(map, st.st_size);
+	close(fd);
+	return 0;
+
+err_map:
+	close(fd);
+err_open:
+	return -1;
+}
+
+/**
+ * hashing a face costs about as much as rasterising a few glyphs, so it's
+ * only done once and kept on the txfont. the font manager hands it on to
+ * other sizes of the same face.
+ */
+static int
+hash_face(struct rtb_texture_font *txfont)
+{
+	const texture_font_t *font = txfont->txfont;
+	uint64_t hash = FNV_OFFSET;
+
+	if (txfont->face_hash)
+		return 0;
+
+	switch (font->location) {
+	case TEXTURE_FONT_MEMORY:
+		hash = fnv1a64(hash, font->memory.base, font->memory.size);
+		break;
+
+	case TEXTURE_FONT_FILE:
+		if (hash_file(font->filename, &hash))
+			return -1;
+		break;
+
+	default:
+		return -1;
+	}
+
+	txfont->face_hash = hash;
+	return 0;
+}
+
+static int
+make_key(struct cache_key *key, struct rtb_texture_font *txfont)
+{
+	const texture_font_t *font = txfont->txfont;
+
+	memset(key, 0, sizeof(*key));
+
+	if (hash_face(txfont))
+		return -1;
+
+	key->font_hash = txfont->face_hash;
+
+	key->size  = font->size;
+	key->dpi_x = font->atlas->dpi.x;
+	key->dpi_y = font->atlas->dpi.y;
+	key->depth = font->atlas->depth;
+
+	key->hinting = font->hinting;
+	key->filtering = font->filtering;
+	key->outline_type = font->outline_type;
+	key->outline_thickness = font->outline_thickness;
+	key->gamma = font->gamma;
+	memcpy(key->lcd_weights, font->lcd_weights, sizeof(font->lcd_weights));
+
+	return 0;
+}
+
+static int
+mkdir_if_needed(const char *path)
+{
+	if (!mkdir(path, 0755) || errno == EEXIST)
+		return 0;
+	return -1;
+}
+
+/**
+ * $XDG_CACHE_HOME/rutabaga/glyphs/<key hash>, creating directories on the
+ * way if `create` is set.
+ */
+static int
+cache_path(char *buf, size_t bufsize, const struct cache_key *key, int create)
+{
+	const char *base, *home;
+	int len;
+
+	if ((base = getenv("XDG_CACHE_HOME")) && *base)
+		len = snprintf(buf, bufsize, "%s", base);
+	else if ((home = getenv("HOME")) && *home)
+		len = snprintf(buf, bufsize, "%s/.cache", home);
+	else
+		return -1;
+
+	if (len < 0 || (size_t) len >= bufsize)
+		return -1;
+
+	if (create && mkdir_if_needed(buf))
+		return -1;
+
+	len += snprintf(buf + len, bufsize - len, "/rutabaga");
+	if ((size_t) len >= bufsize || (create && mkdir_if_needed(buf)))
+		return -1;
+
+	len += snprintf(buf + len, bufsize - len, "/glyphs");
+	if ((size_t) len >= bufsize || (create && mkdir_if_needed(buf)))
+		return -1;
+
+	len += snprintf(buf + len, bufsize - len, "/%016llx",
+			(unsigned long long) fnv1a64(FNV_OFFSET, key, sizeof(*key)));
+
+	if ((size_t) len >= bufsize)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * loading
+ */
+
+static const struct cache_header *
+validate(const void *map, size_t size, const struct cache_key *key)
+{
+	const struct cache_header *hdr = map;
+	uint64_t expected;
+
+	if (size < sizeof(*hdr))
+		return NULL;
+
+	if (hdr->magic != CACHE_MAGIC || hdr->version != CACHE_VERSION
+			|| memcmp(&hdr->key, key, sizeof(*key)))
+		return NULL;
+
+	expected = sizeof(*hdr)
+		+ ((uint64_t) hdr->nglyphs * sizeof(struct cache_glyph))
+		+ ((uint64_t) hdr->nkerning * sizeof(struct cache_kerning))
+		+ hdr->bitmap_size;
+
+	if (expected != size)
+		return NULL;
+
+	return hdr;
+}
+
+static int
+load_glyph(texture_font_t *font, const struct cache_header *hdr,
+		const struct cache_glyph *cg, const struct cache_kerning *kerning,
+		const uint8_t *bitmaps)
+{
+	size_t depth = font->atlas->depth;
+	texture_glyph_t metrics, *glyph;
+	uint64_t bitmap_bytes;
+	uint32_t i;
+
+	bitmap_bytes = (uint64_t) cg->width * cg->height * depth;
+
+	/* the file's the right size, but that doesn't mean the offsets in
+	 * it are sane */
+	if (cg->width >= font->atlas->width || cg->height >= font->atlas->height
+			|| cg->bitmap_offset > hdr->bitmap_size
+			|| bitmap_bytes > hdr->bitmap_size - cg->bitmap_offset
+			|| cg->kerning_start > hdr->nkerning
+			|| cg->nkerning > hdr->nkerning - cg->kerning_start)
+		return -1;
+
+	metrics.charcode  = cg->charcode;
+	metrics.width     = cg->width;
+	metrics.height    = cg->height;
+	metrics.offset_x  = cg->offset_x;
+	metrics.offset_y  = cg->offset_y;
+	metrics.advance_x = cg->advance_x;
+	metrics.advance_y = cg->advance_y;
+
+	glyph = texture_font_add_glyph(font, &metrics,
+			bitmaps + cg->bitmap_offset, cg->width * depth);
+
+	if (!glyph)
+		return -1;
+
+	for (i = 0; i < cg->nkerning; i++) {
+		kerning_t k = {
+			kerning[cg->kerning_start + i].charcode,
+			kerning[cg->kerning_start + i].kerning
+		};
+
+		vector_push_back(glyph->kerning, &k);
+	}
+
+	return 0;
+}
+
+/**
+ * saving
+ */
+
+static const uint8_t *
+atlas_row(const texture_atlas_t *atlas, const texture_glyph_t *glyph,
+		size_t row)
+{
+	size_t x, y;
+
+	x = lroundf(glyph->s0 * atlas->width);
+	y = lroundf(glyph->t0 * atlas->height);
+
+	return atlas->data + (((y + row) * atlas->width) + x) * atlas->depth;
+}
+
+static int
+write_cache(FILE *f, const struct cache_key *key, texture_font_t *font)
+{
+	struct cache_header hdr = {
+		.magic   = CACHE_MAGIC,
+		.version = CACHE_VERSION,
+		.key     = *key
+	};
+
+	size_t i, j, depth = font->atlas->depth;
+	const texture_glyph_t *glyph;
+	struct cache_glyph cg;
+	struct cache_kerning ck;
+	const kerning_t *k;
+
+	/* glyph -1 is the solid block freetype-gl makes for itself when the
+	 * font is created, so it's never worth saving */
+	for (i = 0; i < vector_size(font->glyphs); i++) {
+		glyph = *(texture_glyph_t **) vector_get(font->glyphs, i);
+		if (glyph->charcode == -1)
+			continue;
+
+		hdr.nglyphs++;
+		hdr.nkerning += vector_size(glyph->kerning);
+		hdr.bitmap_size += glyph->width * glyph->height * depth;
+	}
+
+	if (fwrite(&hdr, sizeof(hdr), 1, f) != 1)
+		return -1;
+
+	memset(&cg, 0, sizeof(cg));
+
+	for (i = 0; i < vector_size(font->glyphs); i++) {
+		glyph = *(texture_glyph_t **) vector_get(font->glyphs, i);
+		if (glyph->charcode == -1)
+			continue;
+
+		cg.charcode  = glyph->charcode;
+		cg.width     = glyph->width;
+		cg.height    = glyph->height;
+		cg.offset_x  = glyph->offset_x;
+		cg.offset_y  = glyph->offset_y;
+		cg.advance_x = glyph->advance_x;
+		cg.advance_y = glyph->advance_y;
+		cg.nkerning  = vector_size(glyph->kerning);
+
+		if (fwrite(&cg, sizeof(cg), 1, f) != 1)
+			return -1;
+
+		cg.kerning_start += cg.nkerning;
+		cg.bitmap_offset += glyph->width * glyph->height * depth;
+	}
+
+	for (i = 0; i < vector_size(font->glyphs); i++) {
+		glyph = *(texture_glyph_t **) vector_get(font->glyphs, i);
+		if (glyph->charcode == -1)
+			continue;
+
+		for (j = 0; j < vector_size(glyph->kerning); j++) {
+			k = vector_get(glyph->kerning, j);
+
+			ck.charcode = k->charcode;
+			ck.kerning  = k->kerning;
+
+			if (fwrite(&ck, sizeof(ck), 1, f) != 1)
+				return -1;
+		}
+	}
+
+	for (i = 0; i < vector_size(font->glyphs); i++) {
+		glyph = *(texture_glyph_t **) vector_get(font->glyphs, i);
+		if (glyph->charcode == -1 || !glyph->width)
+			continue;
+
+		for (j = 0; j < glyph->height; j++)
+			if (fwrite(atlas_row(font->atlas, glyph, j),
+						glyph->width * depth, 1, f) != 1)
+				return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * private API
+ */
+
+int
+rtb__glyph_cache_load(struct rtb_texture_font *txfont)
+{
+	texture_font_t *font = txfont->txfont;
+	const struct cache_kerning *kerning;
+	const struct cache_header *hdr;
+	const struct cache_glyph *glyphs;
+	const uint8_t *bitmaps;
+	struct cache_key key;
+	char path[4096];
+	struct stat st;
+	int fd, loaded;
+	void *map;
+	uint32_t i;
+
+	if (make_key(&key, txfont) || cache_path(path, sizeof(path), &key, 0))
+		return -1;
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		goto err_open;
+
+	if (fstat(fd, &st) || st.st_size <= 0)
+		goto err_map;
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		goto err_map;
+
+	if (!(hdr = validate(map, st.st_size, &key)))
+		goto err_validate;
+
+	glyphs  = (const void *) (hdr + 1);
+	kerning = (const void *) (glyphs + hdr->nglyphs);
+	bitmaps = (const void *) (kerning + hdr->nkerning);
+
+	loaded = 0;
+
+	for (i = 0; i < hdr->nglyphs; i++) {
+		if (texture_font_find_glyph(font, glyphs[i].charcode))
+			continue;
+
+		if (load_glyph(font, hdr, &glyphs[i], kerning, bitmaps))
+			break;
+
+		loaded++;
+	}
+
+	munmap(map, st.st_size);
+	close(fd);
+
+	txfont->cached_glyphs = vector_size(font->glyphs);
+	return loaded;
+
+err_validate:
+	munmap(map, st.st_size);
+err_map:
+	close(fd);
+err_open:
+	return -1;
+}
+
+int
+rtb__glyph_cache_save(struct rtb_texture_font *txfont)
+{
+	texture_font_t *font = txfont->txfont;
+	char path[4096], tmp_path[4096 + 32];
+	struct cache_key key;
+	FILE *f;
+
+	if (make_key(&key, txfont) || cache_path(path, sizeof(path), &key, 1))
+		return -1;
+
+	/* write somewhere else and rename() over, so that another process
+	 * loading the same font never sees half a file */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%ld", path, (long) getpid());
+
+	if (!(f = fopen(tmp_path, "wb")))
+		goto err_fopen;
+
+	if (write_cache(f, &key, font))
+		goto err_write;
+
+	if (fclose(f))
+		goto err_fclose;
+
+	if (rename(tmp_path, path))
+		goto err_fclose;
+
+	txfont->cached_glyphs = vector_size(font->glyphs);
+	return 0;
+
+err_write:
+	fclose(f);
+err_fclose:
+	unlink(tmp_path);
+err_fopen:
+	return -1;
+}
@@ -0,0 +1,346 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <bsd/queue.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <hb.h>
+#include <hb-ft.h>
+
+#include <rutabaga/rutabaga.h>
+#include <rutabaga/font-manager.h>
+
+#include "rtb_private/shaper.h"
+
+#define ERR(...) fprintf(stderr, "rutabaga: " __VA_ARGS__)
+
+#define CACHE_BUCKETS     256
+#define CACHE_MAX_ENTRIES 1024
+
+/**
+ * a FreeType face and HarfBuzz font kept open for each texture font we've
+ * shaped with. texture_font_t only opens its face for as long as it takes
+ * to rasterise, which is far too expensive to do per run.
+ */
+struct shaping_font {
+	LIST_ENTRY(shaping_font) entry;
+
+	struct rtb_texture_font *txfont;
+
+	FT_Library library;
+	FT_Face face;
+	hb_font_t *hb_font;
+};
+
+struct cached_run {
+	LIST_ENTRY(cached_run) bucket_entry;
+	TAILQ_ENTRY(cached_run) lru_entry;
+
+	uint32_t hash;
+	const struct rtb_texture_font *txfont;
+
+	size_t len;
+	rtb_utf32_t *text;
+
+	struct rtb_shaped_run run;
+};
+
+struct rtb_shaper {
+	hb_buffer_t *buffer;
+
+	LIST_HEAD(shaping_fonts, shaping_font) fonts;
+
+	LIST_HEAD(run_bucket, cached_run) buckets[CACHE_BUCKETS];
+	TAILQ_HEAD(run_lru, cached_run) lru;
+	unsigned nruns;
+};
+
+/**
+ * fonts
+ */
+
+static struct shaping_font *
+shaping_font_for(struct rtb_shaper *shaper, struct rtb_texture_font *txfont)
+{
+	struct shaping_font *sf;
+
+	LIST_FOREACH(sf, &shaper->fonts, entry)
+		if (sf->txfont == txfont)
+			return sf;
+
+	if (!(sf = calloc(1, sizeof(*sf))))
+		goto err_calloc;
+
+	if (!texture_font_get_shaping_face(txfont->txfont,
+				&sf->library, &sf->face))
+		goto err_face;
+
+	if (!(sf->hb_font = hb_ft_font_create(sf->face, NULL)))
+		goto err_hb_font;
+
+	sf->txfont = txfont;
+	LIST_INSERT_HEAD(&shaper->fonts, sf, entry);
+	return sf;
+
+err_hb_font:
+	FT_Done_Face(sf->face);
+	FT_Done_FreeType(sf->library);
+err_face:
+	free(sf);
+err_calloc:
+	return NULL;
+}
+
+static void
+shaping_font_free(struct shaping_font *sf)
+{
+	LIST_REMOVE(sf, entry);
+
+	hb_font_destroy(sf->hb_font);
+	FT_Done_Face(sf->face);
+	FT_Done_FreeType(sf->library);
+
+	free(sf);
+}
+
+/**
+ * run cache
+ */
+
+static uint32_t
+hash_run(const struct rtb_texture_font *txfont,
+		const rtb_utf32_t *text, size_t len)
+{
+	uintptr_t font_bits = (uintptr_t) txfont;
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	/* FNV-1a over the font pointer and then the codepoints */
+	for (i = 0; i < sizeof(font_bits); i++, font_bits >>= 8)
+		hash = (hash ^ (font_bits & 0xFF)) * 16777619u;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ (uint32_t) text[i]) * 16777619u;
+
+	return hash;
+}
+
+static struct cached_run *
+find_run(struct rtb_shaper *shaper, uint32_t hash,
+		const struct rtb_texture_font *txfont,
+		const rtb_utf32_t *text, size_t len)
+{
+	struct cached_run *cr;
+
+	LIST_FOREACH(cr, &shaper->buckets[hash % CACHE_BUCKETS], bucket_entry) {
+		if (cr->hash == hash && cr->txfont == txfont && cr->len == len
+				&& !memcmp(cr->text, text, len * sizeof(*text)))
+			return cr;
+	}
+
+	return NULL;
+}
+
+static void
+evict_run(struct rtb_shaper *shaper, struct cached_run *cr)
+{
+	LIST_REMOVE(cr, bucket_entry);
+	TAILQ_REMOVE(&shaper->lru, cr, lru_entry);
+	shaper->nruns--;
+
+	free(cr);
+}
+
+static struct cached_run *
+shape_run(struct rtb_shaper *shaper, struct shaping_font *sf, uint32_t hash,
+		const rtb_utf32_t *text, size_t len)
+{
+	hb_glyph_position_t *positions;
+	hb_glyph_info_t *infos;
+	struct cached_run *cr;
+	unsigned i, nglyphs;
+
+	hb_buffer_clear_contents(shaper->buffer);
+	hb_buffer_add_utf32(shaper->buffer,
+			(const uint32_t *) text, len, 0, len);
+	hb_buffer_guess_segment_properties(shaper->buffer);
+
+	hb_shape(sf->hb_font, shaper->buffer, NULL, 0);
+
+	infos = hb_buffer_get_glyph_infos(shaper->buffer, &nglyphs);
+	positions = hb_buffer_get_glyph_positions(shaper->buffer, &nglyphs);
+
+	/* the run's text is stored after its glyphs, in the same block */
+	cr = malloc(sizeof(*cr)
+			+ (nglyphs * sizeof(*cr->run.glyphs))
+			+ (len * sizeof(*text)));
+
+	if (!cr)
+		return NULL;
+
+	cr->hash   = hash;
+	cr->txfont = sf->txfont;
+	cr->len    = len;
+	cr->text   = (void *) &cr->run.glyphs[nglyphs];
+	memcpy(cr->text, text, len * sizeof(*text));
+
+	cr->run.nglyphs = nglyphs;
+
+	/* hb-ft reports positions in 26.6 fixed point */
+	for (i = 0; i < nglyphs; i++) {
+		cr->run.glyphs[i].glyph_index = infos[i].codepoint;
+		cr->run.glyphs[i].cluster     = infos[i].cluster;
+		cr->run.glyphs[i].x_advance   = positions[i].x_advance / 64.f;
+		cr->run.glyphs[i].x_offset    = positions[i].x_offset  / 64.f;
+		cr->run.glyphs[i].y_offset    = positions[i].y_offset  / 64.f;
+	}
+
+	if (shaper->nruns >= CACHE_MAX_ENTRIES)
+		evict_run(shaper, TAILQ_LAST(&shaper->lru, run_lru));
+
+	LIST_INSERT_HEAD(&shaper->buckets[hash % CACHE_BUCKETS],
+			cr, bucket_entry);
+	TAILQ_INSERT_HEAD(&shaper->lru, cr, lru_entry);
+	shaper->nruns++;
+
+	return cr;
+}
+
+/**
+ * private API
+ */
+
+const struct rtb_shaped_run *
+rtb__shaper_shape(struct rtb_font_manager *fm,
+		struct rtb_texture_font *txfont, const rtb_utf32_t *text, size_t len)
+{
+	struct rtb_shaper *shaper = fm->shaper;
+	struct shaping_font *sf;
+	struct cached_run *cr;
+	uint32_t hash;
+
+	if (!shaper || !len)
+		return NULL;
+
+	hash = hash_run(txfont, text, len);
+
+	if ((cr = find_run(shaper, hash, txfont, text, len))) {
+		/* most recently used goes to the front */
+		TAILQ_REMOVE(&shaper->lru, cr, lru_entry);
+		TAILQ_INSERT_HEAD(&shaper->lru, cr, lru_entry);
+		return &cr->run;
+	}
+
+	if (!(sf = shaping_font_for(shaper, txfont)))
+		return NULL;
+
+	if (!(cr = shape_run(shaper, sf, hash, text, len)))
+		return NULL;
+
+	return &cr->run;
+}
+
+void
+rtb__shaper_forget_font(struct rtb_font_manager *fm,
+		struct rtb_texture_font *txfont)
+{
+	struct rtb_shaper *shaper = fm->shaper;
+	struct cached_run *cr, *tmp_cr;
+	struct shaping_font *sf;
+
+	if (!shaper)
+		return;
+
+	TAILQ_FOREACH_SAFE(cr, &shaper->lru, lru_entry, tmp_cr)
+		if (cr->txfont == txfont)
+			evict_run(shaper, cr);
+
+	LIST_FOREACH(sf, &shaper->fonts, entry) {
+		if (sf->txfont == txfont) {
+			shaping_font_free(sf);
+			break;
+		}
+	}
+}
+
+int
+rtb__shaper_init(struct rtb_font_manager *fm)
+{
+	struct rtb_shaper *shaper;
+	int i;
+
+	fm->shaper = NULL;
+
+	if (!(shaper = calloc(1, sizeof(*shaper))))
+		goto err_calloc;
+
+	shaper->buffer = hb_buffer_create();
+	if (!hb_buffer_allocation_successful(shaper->buffer))
+		goto err_buffer;
+
+	LIST_INIT(&shaper->fonts);
+	TAILQ_INIT(&shaper->lru);
+
+	for (i = 0; i < CACHE_BUCKETS; i++)
+		LIST_INIT(&shaper->buckets[i]);
+
+	fm->shaper = shaper;
+	return 0;
+
+err_buffer:
+	hb_buffer_destroy(shaper->buffer);
+	free(shaper);
+err_calloc:
+	ERR("couldn't initialise text shaping, falling back to plain layout\n");
+	return -1;
+}
+
+void
+rtb__shaper_fini(struct rtb_font_manager *fm)
+{
+	struct rtb_shaper *shaper = fm->shaper;
+	struct cached_run *cr;
+
+	if (!shaper)
+		return;
+
+	while ((cr = TAILQ_FIRST(&shaper->lru)))
+		evict_run(shaper, cr);
+
+	while (!LIST_EMPTY(&shaper->fonts))
+		shaping_font_free(LIST_FIRST(&shaper->fonts));
+
+	hb_buffer_destroy(shaper->buffer);
+	free(shaper);
+
+	fm->shaper = NULL;
+}
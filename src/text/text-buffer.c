@@ -38,19 +38,10 @@
 static int
 utf8_idx(struct rtb_text_buffer *self, int idx)
 {
-	int u8_idx, size = self->size;
-
-	for (u8_idx = 0; idx >= 0 && u8_idx <= size; idx--, u8_idx++)
-		while (UTF8_IS_CONTINUATION(self->data[u8_idx]) && u8_idx <= size)
-			u8_idx++;
-
-	if (u8_idx > size)
-		return -1;
-
-	if (u8_idx > 0)
-		u8_idx--;
+	if (idx < 0)
+		return 0;
 
-	return u8_idx;
+	return rtb__u8_offset(self->data, self->size, idx);
 }
 
 /**
@@ -25,6 +25,8 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 #include <rutabaga/rutabaga.h>
 #include <rutabaga/element.h>
@@ -40,6 +42,8 @@
 #include "freetype-gl/vertex-buffer.h"
 
 #include "rtb_private/utf8.h"
+#include "rtb_private/shaper.h"
+#include "rtb_private/stdlib-allocator.h"
 
 struct text_vertex {
 	float x, y;
@@ -47,13 +51,20 @@ struct text_vertex {
 	float shift;
 };
 
+static void build_geometry(struct rtb_text_object *self);
+
 int
 rtb_text_object_get_glyph_rect(struct rtb_text_object *self, int idx,
 		struct rtb_rect *rect)
 {
-	vector_t *vertices = self->vertices->vertices;
+	vector_t *vertices;
 	struct text_vertex *v;
 
+	if (self->geometry_dirty)
+		build_geometry(self);
+
+	vertices = self->vertices->vertices;
+
 	if (idx < 0 || ((size_t) idx * 4) > vector_size(vertices))
 		return -1;
 
@@ -74,6 +85,9 @@ rtb_text_object_get_glyph_rect(struct rtb_text_object *self, int idx,
 int
 rtb_text_object_count_glyphs(struct rtb_text_object *self)
 {
+	if (self->geometry_dirty)
+		build_geometry(self);
+
 	return vector_size(self->vertices->vertices) / 4;
 }
 
@@ -88,111 +102,652 @@ quantize(float x, float modulo, float modulo_recip, float *remainder)
 	return floored * modulo;
 }
 
-int
-rtb_text_object_update(struct rtb_text_object *self,
-		struct rtb_font *rfont, struct rtb_window *win,
-		const rtb_utf8_t *text, float line_height_multiplier)
+#define RESERVE_SCRATCH(vec, n) do {					\
+	if ((vec)->capacity < (n)) {					\
+		VECTOR_FREE(vec);					\
+		VECTOR_INIT(vec, &stdlib_allocator, (n));		\
+	}								\
+} while (0)
+
+#define IS_BREAKING_SPACE(c) ((c) == ' ' || (c) == '\t')
+
+static int
+decode_text(struct rtb_text_object *self, const rtb_utf8_t *text)
 {
-	float x, y, line_height, x0, y0, x1, y1, max_w, scale_x_recip;
-	struct rtb_point scale = win->scale_recip;
-	rtb_utf32_t codepoint, prev_codepoint;
-	uint32_t state, prev_state;
-	texture_font_t *font;
-	unsigned lines;
+	size_t nbytes = strlen(text);
 
-	if (!rfont || !text)
+	/* every byte decodes to at most one codepoint */
+	RESERVE_SCRATCH(&self->codepoints, nbytes);
+	if (!self->codepoints.data)
 		return -1;
 
-	font = rfont->txfont->txfont;
-	self->font = rfont;
-	scale_x_recip = 1.f / scale.x;
+	self->codepoints.size =
+		rtb__u8_decode(self->codepoints.data, text, nbytes);
+	return 0;
+}
 
-	vertex_buffer_clear(self->vertices);
+/**
+ * measurement
+ */
 
-	line_height = (font->height * line_height_multiplier) * scale.y;
+static void
+glyph_metrics(struct rtb_text_glyph *m, const texture_glyph_t *glyph,
+		struct rtb_point scale)
+{
+	m->advance = glyph->advance_x * scale.x;
 
-	x  = 0.f;
-	x1 = 0.f;
-	y  = ceilf(line_height / 2.f)
-		- (font->descender * scale.y)
-		+ 1.f;
+	m->x0 = glyph->offset_x * scale.x;
+	m->x1 = m->x0 + (glyph->width * scale.x);
+	m->y0 = -(glyph->offset_y * scale.y);
+	m->y1 = m->y0 + (glyph->height * scale.y);
+}
 
-	max_w = 0.f;
-	lines = 1;
+static void
+measure_ellipsis(struct rtb_text_object *self, texture_font_t *font)
+{
+	texture_glyph_t *glyph;
+
+	/* U+2026 HORIZONTAL ELLIPSIS if the font has it, three full stops
+	 * if it doesn't. only worth asking the font once. */
+	if (self->ellipsis.font != self->font) {
+		self->ellipsis.font = self->font;
+
+		if (texture_font_has_glyph(font, 0x2026)) {
+			self->ellipsis.codepoint = 0x2026;
+			self->ellipsis.repeat = 1;
+		} else {
+			self->ellipsis.codepoint = '.';
+			self->ellipsis.repeat = 3;
+		}
+	}
+
+	memset(&self->ellipsis.metrics, 0, sizeof(self->ellipsis.metrics));
+
+	if ((glyph = texture_font_get_glyph(font, self->ellipsis.codepoint))) {
+		self->ellipsis.metrics.font = font;
+		self->ellipsis.metrics.charcode = self->ellipsis.codepoint;
+		glyph_metrics(&self->ellipsis.metrics, glyph, self->scale);
+	}
+}
+
+static void
+push_shaped_run(struct rtb_text_object *self, texture_font_t *font,
+		const struct rtb_shaped_run *run, unsigned first_codepoint)
+{
+	struct rtb_point scale = self->scale;
+	const struct rtb_shaped_glyph *sg;
+	struct rtb_text_glyph m;
+	texture_glyph_t *glyph;
+	unsigned i;
+
+	for (i = 0; i < run->nglyphs; i++) {
+		sg = &run->glyphs[i];
+
+		memset(&m, 0, sizeof(m));
+		m.font     = font;
+		m.charcode = sg->glyph_index | TEXTURE_FONT_GLYPH_INDEX;
+		m.cluster  = first_codepoint + sg->cluster;
+
+		if ((glyph = texture_font_get_glyph(font, m.charcode)))
+			glyph_metrics(&m, glyph, scale);
+		else
+			m.charcode = 0;
+
+		/* the shaper's advances already include kerning */
+		m.advance = sg->x_advance * scale.x;
+
+		m.x0 += sg->x_offset * scale.x;
+		m.x1 += sg->x_offset * scale.x;
+		m.y0 -= sg->y_offset * scale.y;
+		m.y1 -= sg->y_offset * scale.y;
+
+		VECTOR_PUSH_BACK(&self->glyphs, &m);
+	}
+}
+
+/**
+ * looks up every glyph once and caches what line breaking needs, so that
+ * re-wrapping at a different width doesn't have to go back to the font.
+ *
+ * each codepoint is drawn from the first font in the fallback chain that
+ * has it.
+ *
+ * with a shaper, each run of non-space codepoints that falls to the same
+ * font is shaped as a unit (the shaper caches runs, so repeated words are
+ * cheap). whitespace and newlines are always laid out directly, since
+ * they're where lines break.
+ */
+static int
+measure_glyphs(struct rtb_text_object *self)
+{
+	const rtb_utf32_t *cp = self->codepoints.data;
+	const struct rtb_font *rfont, *prev_rfont;
+	const struct rtb_shaped_run *run;
+	rtb_utf32_t prev_codepoint;
+	struct rtb_text_glyph m;
+	texture_glyph_t *glyph;
+	texture_font_t *font;
+	unsigned i, run_end, n;
+	int shaping;
+
+	n = self->codepoints.size;
 
-	state = prev_state = UTF8_ACCEPT;
+	VECTOR_CLEAR(&self->glyphs);
+
+	shaping = self->shaping && self->fm->shaper;
 	prev_codepoint = 0;
+	prev_rfont = NULL;
 
-	for (; *text; prev_state = state, text++) {
-		texture_glyph_t *glyph;
-		float s0, t0, s1, t1, x0_shift, x1_shift;
+	for (i = 0; i < n;) {
+		rfont = rtb_font_for_codepoint(self->font, cp[i]);
+		font = rfont->txfont->txfont;
 
-		switch(u8dec(&state, &codepoint, *text)) {
-		case UTF8_ACCEPT:
-			break;
+		if (shaping && !IS_BREAKING_SPACE(cp[i]) && cp[i] != '\n') {
+			for (run_end = i + 1; run_end < n
+					&& !IS_BREAKING_SPACE(cp[run_end])
+					&& cp[run_end] != '\n'
+					&& rtb_font_for_codepoint(self->font,
+						cp[run_end]) == rfont; run_end++);
 
-		case UTF8_REJECT:
-			if (prev_state != UTF8_ACCEPT)
-				text--;
+			run = rtb__shaper_shape(self->fm, rfont->txfont,
+					&cp[i], run_end - i);
 
-			codepoint = 0xFFFD;
-			state = UTF8_ACCEPT;
-			break;
+			if (run) {
+				push_shaped_run(self, font, run, i);
 
-		default:
-			continue;
+				prev_codepoint = 0;
+				i = run_end;
+				continue;
+			}
+
+			/* if the shaper can't cope, it's not going to do any
+			 * better with the rest of the text */
+			shaping = 0;
 		}
 
-		if (codepoint == '\n') {
-			lines++;
+		memset(&m, 0, sizeof(m));
+		m.cluster = i;
 
-			if (x > max_w)
-				max_w = x;
+		if (cp[i] == '\n')
+			prev_codepoint = 0;
+		else if ((glyph = texture_font_get_glyph(font, cp[i]))) {
+			m.font = font;
+			m.charcode = cp[i];
+			glyph_metrics(&m, glyph, self->scale);
 
-			y += line_height;
-			x = x1 = 0.f;
-			continue;
+			/* no kerning across a change of font */
+			if (prev_codepoint && rfont == prev_rfont)
+				m.kerning = texture_glyph_get_kerning(glyph,
+						prev_codepoint) * self->scale.x;
+
+			prev_codepoint = cp[i];
+			prev_rfont = rfont;
 		}
 
-		glyph = texture_font_get_glyph(font, codepoint);
-		if (!glyph)
+		VECTOR_PUSH_BACK(&self->glyphs, &m);
+		i++;
+	}
+
+	measure_ellipsis(self, self->font->txfont->txfont);
+	return 0;
+}
+
+static rtb_utf32_t
+glyph_codepoint(const struct rtb_text_object *self, unsigned i)
+{
+	return self->codepoints.data[self->glyphs.data[i].cluster];
+}
+
+static void
+find_words(struct rtb_text_object *self)
+{
+	const struct rtb_text_glyph *m = self->glyphs.data;
+	unsigned i, n = self->glyphs.size;
+	struct rtb_text_word word;
+	rtb_utf32_t c;
+
+	VECTOR_CLEAR(&self->words);
+	i = 0;
+
+	/* there's always at least one word, even if it's empty, so that
+	 * every line (including a trailing empty one) is represented. */
+	do {
+		word.start = i;
+		word.width = 0.f;
+
+		for (; i < n; i++) {
+			c = glyph_codepoint(self, i);
+			if (IS_BREAKING_SPACE(c) || c == '\n')
+				break;
+
+			if (i > word.start)
+				word.width += m[i].kerning;
+
+			word.width += m[i].advance;
+		}
+
+		word.end = i;
+		word.space = 0.f;
+
+		for (; i < n && IS_BREAKING_SPACE(glyph_codepoint(self, i)); i++)
+			word.space += m[i].kerning + m[i].advance;
+
+		word.hard_break = (i < n && glyph_codepoint(self, i) == '\n');
+		if (word.hard_break)
+			i++;
+
+		word.next = i;
+
+		VECTOR_PUSH_BACK(&self->words, &word);
+	} while (i < n || word.hard_break);
+}
+
+/**
+ * line breaking
+ */
+
+static void
+push_line(struct rtb_text_object *self,
+		unsigned start, unsigned end, float width)
+{
+	struct rtb_text_line line = {
+		.start  = start,
+		.end    = end,
+		.cut    = end,
+		.resume = end,
+		.width  = width
+	};
+
+	VECTOR_PUSH_BACK(&self->line_info, &line);
+}
+
+static float
+range_width(const struct rtb_text_glyph *m, unsigned start, unsigned end)
+{
+	float w = 0.f;
+	unsigned i;
+
+	for (i = start; i < end; i++)
+		w += ((i > start) ? m[i].kerning : 0.f) + m[i].advance;
+
+	return w;
+}
+
+/**
+ * greedy word wrap. words wider than the whole line get broken between
+ * codepoints.
+ */
+static void
+wrap_lines(struct rtb_text_object *self, float max_width)
+{
+	const struct rtb_text_glyph *m = self->glyphs.data;
+	const struct rtb_text_word *word, *prev;
+	unsigned line_start, i;
+	float w, step;
+	size_t k;
+
+	line_start = 0;
+	prev = NULL;
+	w = 0.f;
+
+	for (k = 0; k < self->words.size; k++) {
+		word = &self->words.data[k];
+
+		if (prev) {
+			step = prev->space + m[word->start].kerning + word->width;
+
+			if (w + step <= max_width) {
+				w += step;
+				goto next_word;
+			}
+
+			push_line(self, line_start, prev->end, w);
+		}
+
+		line_start = word->start;
+		w = word->width;
+
+		if (w > max_width) {
+			w = 0.f;
+
+			for (i = word->start; i < word->end; i++) {
+				step = ((i > line_start) ? m[i].kerning : 0.f)
+					+ m[i].advance;
+
+				if (w + step > max_width && i > line_start) {
+					push_line(self, line_start, i, w);
+					line_start = i;
+					step = m[i].advance;
+					w = 0.f;
+				}
+
+				w += step;
+			}
+		}
+
+next_word:
+		if (word->hard_break) {
+			push_line(self, line_start, word->end, w);
+			prev = NULL;
+		} else
+			prev = word;
+	}
+
+	if (prev)
+		push_line(self, line_start, prev->end, w);
+}
+
+/**
+ * one line per '\n', with trailing whitespace kept, like it always was.
+ */
+static void
+hard_lines(struct rtb_text_object *self)
+{
+	const struct rtb_text_word *word;
+	unsigned line_start = 0, end;
+	size_t k;
+
+	for (k = 0; k < self->words.size; k++) {
+		word = &self->words.data[k];
+
+		if (!word->hard_break && word->next < self->glyphs.size)
 			continue;
 
-		if (prev_codepoint)
-			x += (texture_glyph_get_kerning(glyph, prev_codepoint) * scale.x);
+		end = word->hard_break ? word->next - 1 : word->next;
 
-		s0 = glyph->s0;
-		s1 = glyph->s1;
+		push_line(self, line_start, end,
+				range_width(self->glyphs.data, line_start, end));
+		line_start = word->next;
+	}
+}
 
-		t0 = glyph->t0;
-		t1 = glyph->t1;
+static void
+ellipsize(struct rtb_text_object *self, struct rtb_text_line *line,
+		float max_width)
+{
+	const struct rtb_text_glyph *m = self->glyphs.data;
+	float avail, head, tail, step, ellipsis_w;
+	unsigned i;
+
+	ellipsis_w = self->ellipsis.metrics.advance * self->ellipsis.repeat;
+	avail = max_width - ellipsis_w;
+
+	if (line->width <= max_width)
+		return;
+
+	head = tail = 0.f;
 
-		x0 = x  + (glyph->offset_x * scale.x);
-		x1 = x0 + (glyph->width * scale.x);
-		y0 = y  - (glyph->offset_y * scale.y);
-		y1 = y0 + (glyph->height * scale.y);
+	if (self->overflow == RTB_TEXT_OVERFLOW_ELLIPSIS_MIDDLE) {
+		/* the tail gets whatever the head doesn't use */
+		for (i = line->start; i < line->end; i++) {
+			step = ((i > line->start) ? m[i].kerning : 0.f) + m[i].advance;
+			if (head + step > avail / 2.f)
+				break;
 
-		x0 = quantize(x0, scale.x, scale_x_recip, &x0_shift);
-		x1 = quantize(x1, scale.x, scale_x_recip, &x1_shift);
+			head += step;
+		}
 
-		GLuint indices[6] = {0, 1, 2, 0, 2, 3};
-		struct text_vertex vertices[4] = {
-			{x0, y0, s0, t0, x0_shift},
-			{x0, y1, s0, t1, x0_shift},
-			{x1, y1, s1, t1, x1_shift},
-			{x1, y0, s1, t0, x1_shift}
-		};
+		line->cut = i;
 
-		vertex_buffer_push_back(self->vertices, vertices, 4, indices, 6);
+		for (i = line->end; i > line->cut; i--) {
+			step = m[i - 1].advance
+				+ ((i < line->end) ? m[i].kerning : 0.f);
+			if (head + tail + step > avail)
+				break;
 
-		x += glyph->advance_x * scale.x;
-		prev_codepoint = codepoint;
+			tail += step;
+		}
+
+		line->resume = i;
+	} else {
+		for (i = line->start; i < line->end; i++) {
+			step = ((i > line->start) ? m[i].kerning : 0.f) + m[i].advance;
+			if (head + step > avail)
+				break;
+
+			head += step;
+		}
+
+		line->cut = i;
+		line->resume = line->end;
+	}
+
+	/* the width has room for the ellipsis, so it's drawn even if
+	 * nothing ended up being cut */
+	line->ellipsized = 1;
+	line->width = head + ellipsis_w + tail;
+}
+
+static void
+break_lines(struct rtb_text_object *self)
+{
+	float max_width = self->max_width;
+	size_t i;
+
+	VECTOR_CLEAR(&self->line_info);
+
+	if (max_width <= 0.f) {
+		hard_lines(self);
+		return;
+	}
+
+	switch (self->overflow) {
+	case RTB_TEXT_OVERFLOW_VISIBLE:
+		hard_lines(self);
+		break;
+
+	case RTB_TEXT_OVERFLOW_WRAP:
+		wrap_lines(self, max_width);
+		break;
+
+	case RTB_TEXT_OVERFLOW_ELLIPSIS_END:
+	case RTB_TEXT_OVERFLOW_ELLIPSIS_MIDDLE:
+		hard_lines(self);
+
+		for (i = 0; i < self->line_info.size; i++)
+			ellipsize(self, &self->line_info.data[i], max_width);
+
+		break;
+	}
+}
+
+/**
+ * placement
+ */
+
+static void
+place_glyph(struct rtb_text_object *self, vertex_buffer_t *vertices,
+		const struct rtb_text_glyph *m, float x, float y,
+		struct rtb_rect *bbox)
+{
+	float s0, t0, s1, t1, x0, y0, x1, y1, x0_shift, x1_shift;
+	struct rtb_point scale = self->scale;
+	texture_glyph_t *glyph;
+
+	x0 = x + m->x0;
+	x1 = x + m->x1;
+	y0 = y + m->y0;
+	y1 = y + m->y1;
+
+	if (x0 != x1) {
+		bbox->x  = fminf(bbox->x,  x0);
+		bbox->y  = fminf(bbox->y,  y0);
+		bbox->x2 = fmaxf(bbox->x2, x1);
+		bbox->y2 = fmaxf(bbox->y2, y1);
+	}
+
+	if (!vertices || !m->charcode)
+		return;
+
+	glyph = texture_font_get_glyph(m->font, m->charcode);
+	if (!glyph)
+		return;
+
+	s0 = glyph->s0;
+	s1 = glyph->s1;
+
+	t0 = glyph->t0;
+	t1 = glyph->t1;
+
+	x0 = quantize(x0, scale.x, 1.f / scale.x, &x0_shift);
+	x1 = quantize(x1, scale.x, 1.f / scale.x, &x1_shift);
+
+	if (x0_shift != 0.f || x1_shift != 0.f)
+		self->subpixel_shifted = 1;
+
+	GLuint indices[6] = {0, 1, 2, 0, 2, 3};
+	struct text_vertex quad[4] = {
+		{x0, y0, s0, t0, x0_shift},
+		{x0, y1, s0, t1, x0_shift},
+		{x1, y1, s1, t1, x1_shift},
+		{x1, y0, s1, t0, x1_shift}
+	};
+
+	vertex_buffer_push_back(vertices, quad, 4, indices, 6);
+}
+
+static float
+place_ellipsis(struct rtb_text_object *self, vertex_buffer_t *vertices,
+		float x, float y, struct rtb_rect *bbox)
+{
+	int i;
+
+	for (i = 0; i < self->ellipsis.repeat; i++) {
+		place_glyph(self, vertices, &self->ellipsis.metrics, x, y, bbox);
+		x += self->ellipsis.metrics.advance;
+	}
+
+	return x;
+}
+
+/**
+ * walks the broken lines and positions each glyph, entirely from cached
+ * metrics. if `vertices` is non-NULL, the glyph quads get pushed into it
+ * as well, which is the only time we go back to the font (for texture
+ * coordinates).
+ */
+static void
+place_glyphs(struct rtb_text_object *self, vertex_buffer_t *vertices)
+{
+	const struct rtb_text_glyph *m = self->glyphs.data;
+	const struct rtb_text_line *line;
+	texture_font_t *font;
+	struct rtb_rect bbox;
+	float x, y, max_w;
+	unsigned i;
+	size_t k;
+
+	font = self->font->txfont->txfont;
+
+	y = ceilf(self->line_height / 2.f)
+		- (font->descender * self->scale.y)
+		+ 1.f;
+
+	bbox.x  = bbox.y  =  INFINITY;
+	bbox.x2 = bbox.y2 = -INFINITY;
+
+	max_w = 0.f;
+
+	for (k = 0; k < self->line_info.size; k++) {
+		line = &self->line_info.data[k];
+		x = 0.f;
+
+		for (i = line->start; i < line->end; i++) {
+			if (i == line->cut && line->ellipsized) {
+				x = place_ellipsis(self, vertices, x, y, &bbox);
+
+				i = line->resume;
+				if (i == line->end)
+					break;
+			} else if (i > line->start)
+				x += m[i].kerning;
+
+			place_glyph(self, vertices, &m[i], x, y, &bbox);
+			x += m[i].advance;
+		}
+
+		if (line->ellipsized && line->cut == line->end)
+			place_ellipsis(self, vertices, x, y, &bbox);
+
+		if (line->width > max_w)
+			max_w = line->width;
+
+		y += self->line_height;
 	}
 
-	vertex_buffer_upload(self->vertices);
-	self->h = line_height * lines;
-	self->w = ceilf((x > max_w) ? x : max_w) + 1;
+	/* no visible glyphs */
+	if (bbox.x > bbox.x2)
+		bbox.x = bbox.y = bbox.x2 = bbox.y2 = 0.f;
+
+	self->bbox  = bbox;
+	self->lines = self->line_info.size;
+	self->h = self->line_height * self->lines;
+	self->w = ceilf(max_w) + 1;
+}
+
+static void
+build_geometry(struct rtb_text_object *self)
+{
+	vertex_buffer_clear(self->vertices);
+	self->geometry_dirty = 0;
+	self->subpixel_shifted = 0;
+
+	if (!self->font)
+		return;
+
+	/* the vertex buffer is uploaded lazily by vertex_buffer_render(),
+	 * so this doesn't need a GL context either. */
+	place_glyphs(self, self->vertices);
+}
+
+/**
+ * public API
+ */
+
+void
+rtb_text_object_constrain(struct rtb_text_object *self,
+		float max_width, rtb_text_overflow_t overflow)
+{
+	if (max_width == self->max_width && overflow == self->overflow)
+		return;
+
+	self->max_width = max_width;
+	self->overflow  = overflow;
+
+	if (!self->font)
+		return;
 
+	break_lines(self);
+	place_glyphs(self, NULL);
+	self->geometry_dirty = 1;
+}
+
+int
+rtb_text_object_update(struct rtb_text_object *self,
+		struct rtb_font *rfont, struct rtb_window *win,
+		const rtb_utf8_t *text, float line_height_multiplier)
+{
+	if (!rfont || !rfont->txfont || !text)
+		return -1;
+
+	rtb_font_ready(rfont);
+
+	if (decode_text(self, text))
+		return -1;
+
+	self->font  = rfont;
+	self->scale = win->scale_recip;
+	self->line_height = (rfont->txfont->txfont->height
+			* line_height_multiplier) * self->scale.y;
+
+	if (measure_glyphs(self))
+		return -1;
+
+	find_words(self);
+	break_lines(self);
+	place_glyphs(self, NULL);
+
+	self->geometry_dirty = 1;
 	return 0;
 }
 
@@ -215,6 +770,18 @@ x_correction(const struct rtb_window *window, float x)
 	return floorf(correction * 1000.f) / 1000.f;
 }
 
+static rtb_text_shader_t
+shader_for(const struct rtb_text_object *self, const texture_atlas_t *atlas)
+{
+	if (atlas->depth == 1)
+		return RTB_TEXT_SHADER_GRAYSCALE;
+
+	if (self->subpixel_shifted)
+		return RTB_TEXT_SHADER_LCD_SUBPIXEL;
+
+	return RTB_TEXT_SHADER_LCD;
+}
+
 void
 rtb_text_object_render(struct rtb_text_object *self,
 		struct rtb_render_context *ctx, float x, float y,
@@ -224,23 +791,31 @@ rtb_text_object_render(struct rtb_text_object *self,
 	struct rtb_font_manager *fm;
 	texture_atlas_t *atlas;
 
+	if (self->geometry_dirty)
+		build_geometry(self);
+
 	if (!vertex_buffer_size(self->vertices))
 		return;
 
 	x += x_correction(ctx->window, x);
 
 	fm = self->fm;
-	shader = &fm->shader;
-	atlas = fm->atlas;
+
+	/* fallbacks are always in the same atlas as the font they're
+	 * falling back from */
+	atlas = self->font->txfont->txfont->atlas;
+	shader = &fm->shaders[shader_for(self, atlas)];
 
 	rtb_render_use_shader(ctx, RTB_SHADER(shader));
+
+	if (atlas->dirty)
+		texture_atlas_upload(atlas);
+
 	glBindTexture(GL_TEXTURE_2D, atlas->id);
 
 	glUniform1i(shader->tex, 0);
-	glUniform1f(shader->gamma, self->font->lcd_gamma);
-
-	glUniform3f(shader->atlas_pixel,
-			1.f / atlas->width, 1.f / atlas->height, atlas->depth);
+	glUniform2f(shader->atlas_pixel,
+			1.f / atlas->width, 1.f / atlas->height);
 
 	glBlendFuncSeparate(
 		GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
@@ -258,6 +833,12 @@ rtb_text_object_new(struct rtb_font_manager *fm)
 	struct rtb_text_object *self = calloc(1, sizeof(*self));
 
 	self->fm = fm;
+	self->shaping = 1;
+
+	VECTOR_INIT(&self->codepoints, &stdlib_allocator, 32);
+	VECTOR_INIT(&self->glyphs, &stdlib_allocator, 32);
+	VECTOR_INIT(&self->words, &stdlib_allocator, 8);
+	VECTOR_INIT(&self->line_info, &stdlib_allocator, 1);
 	self->vertices = vertex_buffer_new("vertex:2f,tex_coord:2f,subpixel_shift:1f");
 
 	return self;
@@ -267,5 +848,9 @@ void
 rtb_text_object_free(struct rtb_text_object *self)
 {
 	vertex_buffer_delete(self->vertices);
+	VECTOR_FREE(&self->line_info);
+	VECTOR_FREE(&self->words);
+	VECTOR_FREE(&self->glyphs);
+	VECTOR_FREE(&self->codepoints);
 	free(self);
 }
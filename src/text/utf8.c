@@ -0,0 +1,304 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+#include <rutabaga/types.h>
+
+#include "rtb_private/utf8.h"
+
+#define IS_CONTINUATION(byte) (((byte) & 0xC0) == 0x80)
+
+/**
+ * block primitives
+ *
+ * `high_bits()` returns a bitmask of the bytes in the block which have
+ * their top bit set (i.e. aren't ASCII), `lead_bytes()` a bitmask of the
+ * bytes which start a codepoint (i.e. aren't continuation bytes).
+ *
+ * continuation bytes are 0x80-0xBF, which as signed chars is -128 to
+ * -65, so anything greater than -65 is a lead byte.
+ */
+
+#if defined(__AVX2__)
+
+# define BLOCK_SIZE 32
+
+static inline __m256i
+load_block(const uint8_t *p)
+{
+	return _mm256_loadu_si256((const void *) p);
+}
+
+static inline uint32_t
+high_bits(__m256i block)
+{
+	return _mm256_movemask_epi8(block);
+}
+
+static inline uint32_t
+lead_bytes(__m256i block)
+{
+	return _mm256_movemask_epi8(
+			_mm256_cmpgt_epi8(block, _mm256_set1_epi8(-65)));
+}
+
+static inline void
+widen_block(rtb_utf32_t *dst, const uint8_t *src)
+{
+	int i;
+
+	for (i = 0; i < BLOCK_SIZE; i += 8)
+		_mm256_storeu_si256((void *) &dst[i], _mm256_cvtepu8_epi32(
+					_mm_loadl_epi64((const void *) &src[i])));
+}
+
+#elif defined(__SSE2__)
+
+# define BLOCK_SIZE 16
+
+static inline __m128i
+load_block(const uint8_t *p)
+{
+	return _mm_loadu_si128((const void *) p);
+}
+
+static inline uint32_t
+high_bits(__m128i block)
+{
+	return _mm_movemask_epi8(block);
+}
+
+static inline uint32_t
+lead_bytes(__m128i block)
+{
+	return _mm_movemask_epi8(
+			_mm_cmpgt_epi8(block, _mm_set1_epi8(-65)));
+}
+
+static inline void
+widen_block(rtb_utf32_t *dst, const uint8_t *src)
+{
+	__m128i zero, block, lo, hi;
+
+	zero  = _mm_setzero_si128();
+	block = load_block(src);
+
+	lo = _mm_unpacklo_epi8(block, zero);
+	hi = _mm_unpackhi_epi8(block, zero);
+
+	_mm_storeu_si128((void *) &dst[0],  _mm_unpacklo_epi16(lo, zero));
+	_mm_storeu_si128((void *) &dst[4],  _mm_unpackhi_epi16(lo, zero));
+	_mm_storeu_si128((void *) &dst[8],  _mm_unpacklo_epi16(hi, zero));
+	_mm_storeu_si128((void *) &dst[12], _mm_unpackhi_epi16(hi, zero));
+}
+
+#endif
+
+/**
+ * ascii runs
+ */
+
+static size_t
+ascii_run(const uint8_t *s, size_t nbytes)
+{
+	size_t i = 0;
+
+#ifdef BLOCK_SIZE
+	for (; i + BLOCK_SIZE <= nbytes; i += BLOCK_SIZE) {
+		uint32_t mask = high_bits(load_block(&s[i]));
+
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+
+	for (; i < nbytes && !(s[i] & 0x80); i++);
+	return i;
+}
+
+static size_t
+decode_ascii_run(rtb_utf32_t *dst, const uint8_t *s, size_t nbytes)
+{
+	size_t i = 0;
+
+#ifdef BLOCK_SIZE
+	for (; i + BLOCK_SIZE <= nbytes; i += BLOCK_SIZE) {
+		if (high_bits(load_block(&s[i])))
+			break;
+
+		widen_block(&dst[i], &s[i]);
+	}
+#endif
+
+	for (; i < nbytes && !(s[i] & 0x80); i++)
+		dst[i] = s[i];
+
+	return i;
+}
+
+/**
+ * public API
+ */
+
+size_t
+rtb__u8_ascii_prefix(const rtb_utf8_t *str, size_t nbytes)
+{
+	return ascii_run((const uint8_t *) str, nbytes);
+}
+
+size_t
+rtb__u8_valid_prefix(const rtb_utf8_t *str, size_t nbytes)
+{
+	const uint8_t *s = (const uint8_t *) str;
+	uint32_t state = UTF8_ACCEPT;
+	size_t i = 0, valid = 0;
+	rtb_utf32_t codepoint;
+
+	while (i < nbytes) {
+		if (state == UTF8_ACCEPT) {
+			i += ascii_run(&s[i], nbytes - i);
+			valid = i;
+
+			if (i == nbytes)
+				break;
+		}
+
+		switch (u8dec(&state, &codepoint, s[i++])) {
+		case UTF8_ACCEPT:
+			valid = i;
+			break;
+
+		case UTF8_REJECT:
+			return valid;
+		}
+	}
+
+	return valid;
+}
+
+size_t
+rtb__u8_count(const rtb_utf8_t *str, size_t nbytes)
+{
+	const uint8_t *s = (const uint8_t *) str;
+	size_t i = 0, ret = 0;
+
+#ifdef BLOCK_SIZE
+	for (; i + BLOCK_SIZE <= nbytes; i += BLOCK_SIZE)
+		ret += __builtin_popcount(lead_bytes(load_block(&s[i])));
+#endif
+
+	for (; i < nbytes; i++)
+		if (!IS_CONTINUATION(s[i]))
+			ret++;
+
+	return ret;
+}
+
+ssize_t
+rtb__u8_offset(const rtb_utf8_t *str, size_t nbytes, size_t idx)
+{
+	const uint8_t *s = (const uint8_t *) str;
+	size_t i = 0;
+
+#ifdef BLOCK_SIZE
+	for (; i + BLOCK_SIZE <= nbytes; i += BLOCK_SIZE) {
+		uint32_t mask = lead_bytes(load_block(&s[i]));
+		size_t leads = __builtin_popcount(mask);
+
+		if (idx < leads) {
+			/* clear the lowest set bit `idx` times */
+			for (; idx; idx--)
+				mask &= mask - 1;
+
+			return i + __builtin_ctz(mask);
+		}
+
+		idx -= leads;
+	}
+#endif
+
+	for (; i < nbytes; i++)
+		if (!IS_CONTINUATION(s[i]) && !idx--)
+			return i;
+
+	return -1;
+}
+
+size_t
+rtb__u8_decode(rtb_utf32_t *dst, const rtb_utf8_t *str, size_t nbytes)
+{
+	const uint8_t *s = (const uint8_t *) str;
+	uint32_t state, prev_state;
+	rtb_utf32_t *out = dst;
+	size_t i = 0;
+
+	state = UTF8_ACCEPT;
+
+	while (i < nbytes) {
+		if (state == UTF8_ACCEPT) {
+			size_t run = decode_ascii_run(out, &s[i], nbytes - i);
+
+			out += run;
+			i   += run;
+
+			if (i == nbytes)
+				break;
+		}
+
+		prev_state = state;
+
+		switch (u8dec(&state, out, s[i])) {
+		case UTF8_ACCEPT:
+			out++;
+			break;
+
+		case UTF8_REJECT:
+			*out++ = 0xFFFD;
+			state = UTF8_ACCEPT;
+
+			/* if we were in the middle of a sequence, this byte
+			 * might be the start of a new one, so run it through
+			 * the decoder again. */
+			if (prev_state != UTF8_ACCEPT)
+				continue;
+
+			break;
+		}
+
+		i++;
+	}
+
+	return out - dst;
+}
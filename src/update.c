@@ -0,0 +1,329 @@
+/**
+ * rutabaga: an OpenGL widget toolkit
+ * Copyright (c) 2013-2018 William Light.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <rutabaga/rutabaga.h>
+#include <rutabaga/window.h>
+#include <rutabaga/element.h>
+#include <rutabaga/platform.h>
+#include <rutabaga/update.h>
+
+#include "rtb_private/update.h"
+#include "rtb_private/stdlib-allocator.h"
+
+#define MIN_QUEUE_CAPACITY 16
+
+struct rtb_update_queue {
+	struct rtb_window *window;
+	TAILQ_ENTRY(rtb_update_queue) entry;
+
+	uint32_t mask;
+
+	/* the producer and the window each write one of these, so keep them
+	 * on separate cache lines. */
+	uint32_t head;
+	char head_pad[64];
+	uint32_t tail;
+	char tail_pad[64];
+
+	struct rtb_update entries[];
+};
+
+/**
+ * handles
+ */
+
+static struct rtb__elem_handle_slot *
+live_slot(struct rtb_window *win, struct rtb_elem_handle handle)
+{
+	struct rtb__elem_handle_slot *slot;
+
+	if (handle.index >= win->handle_slots.size)
+		return NULL;
+
+	slot = &win->handle_slots.data[handle.index];
+	if (!slot->elem || slot->generation != handle.generation)
+		return NULL;
+
+	return slot;
+}
+
+struct rtb_elem_handle
+rtb_elem_get_handle(struct rtb_element *elem)
+{
+	struct rtb_window *win = elem->window;
+	struct rtb__elem_handle_slot *slot, fresh = {
+		.elem = NULL,
+		.generation = 1
+	};
+	uint32_t index;
+
+	assert(win);
+
+	if (elem->handle.generation)
+		return elem->handle;
+
+	if (win->free_handle) {
+		index = win->free_handle - 1;
+		slot = &win->handle_slots.data[index];
+		win->free_handle = slot->next_free;
+	} else {
+		index = win->handle_slots.size;
+		VECTOR_PUSH_BACK(&win->handle_slots, &fresh);
+		slot = VECTOR_BACK(&win->handle_slots);
+	}
+
+	slot->elem = elem;
+	slot->next_free = 0;
+	slot->pending = 0;
+
+	elem->handle.index = index;
+	elem->handle.generation = slot->generation;
+	return elem->handle;
+}
+
+struct rtb_element *
+rtb_elem_from_handle(struct rtb_window *win, struct rtb_elem_handle handle)
+{
+	struct rtb__elem_handle_slot *slot = live_slot(win, handle);
+	return slot ? slot->elem : NULL;
+}
+
+void
+rtb__elem_handle_release(struct rtb_element *elem)
+{
+	struct rtb_window *win = elem->window;
+	struct rtb__elem_handle_slot *slot;
+
+	if (!elem->handle.generation)
+		return;
+
+	slot = &win->handle_slots.data[elem->handle.index];
+
+	slot->elem = NULL;
+	slot->pending = 0;
+
+	/* generation 0 means "no handle". */
+	if (!++slot->generation)
+		slot->generation = 1;
+
+	slot->next_free = win->free_handle;
+	win->free_handle = elem->handle.index + 1;
+
+	elem->handle.index = 0;
+	elem->handle.generation = 0;
+}
+
+/**
+ * queues
+ */
+
+struct rtb_update_queue *
+rtb_update_queue_new(struct rtb_window *win, unsigned capacity)
+{
+	struct rtb_update_queue *self;
+	uint32_t size;
+
+	for (size = MIN_QUEUE_CAPACITY; size < capacity; size <<= 1);
+
+	self = malloc(sizeof(*self) + size * sizeof(*self->entries));
+	if (!self)
+		return NULL;
+
+	self->window = win;
+	self->mask = size - 1;
+	self->head = 0;
+	self->tail = 0;
+
+	TAILQ_INSERT_TAIL(&win->update_queues, self, entry);
+	return self;
+}
+
+void
+rtb_update_queue_free(struct rtb_update_queue *self)
+{
+	TAILQ_REMOVE(&self->window->update_queues, self, entry);
+	free(self);
+}
+
+int
+rtb_update_post(struct rtb_update_queue *self, struct rtb_elem_handle target,
+		unsigned kind, union rtb_update_value value)
+{
+	struct rtb_window *win = self->window;
+	struct rtb_update *slot;
+	uint32_t head, tail;
+
+	/* we're the only writer of `head`. */
+	head = self->head;
+	tail = __atomic_load_n(&self->tail, __ATOMIC_ACQUIRE);
+
+	if (head - tail > self->mask)
+		return -1;
+
+	slot = &self->entries[head & self->mask];
+	slot->target = target;
+	slot->kind = kind;
+	slot->value = value;
+
+	__atomic_store_n(&self->head, head + 1, __ATOMIC_RELEASE);
+
+	/* only the first update after a drain has to ask for a frame. */
+	if (__atomic_exchange_n(&win->updates_need_wakeup, 0, __ATOMIC_ACQ_REL))
+		rtb__platform_request_frame(win);
+
+	return 0;
+}
+
+/**
+ * draining
+ */
+
+static void
+coalesce(struct rtb_window *win, const struct rtb_update *update)
+{
+	struct rtb__elem_handle_slot *slot;
+	struct rtb__pending_update *pending, fresh;
+	uint32_t link;
+
+	if (!(slot = live_slot(win, update->target)))
+		return;
+
+	for (link = slot->pending; link; link = pending->next) {
+		pending = &win->pending_updates.data[link - 1];
+
+		if (pending->update.kind == update->kind) {
+			pending->update.value = update->value;
+			return;
+		}
+	}
+
+	fresh.update = *update;
+	fresh.next = slot->pending;
+
+	VECTOR_PUSH_BACK(&win->pending_updates, &fresh);
+	slot->pending = win->pending_updates.size;
+}
+
+static void
+drain_queue(struct rtb_window *win, struct rtb_update_queue *queue)
+{
+	uint32_t head, tail;
+
+	head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+	for (tail = queue->tail; tail != head; tail++)
+		coalesce(win, &queue->entries[tail & queue->mask]);
+
+	__atomic_store_n(&queue->tail, tail, __ATOMIC_RELEASE);
+}
+
+void
+rtb__update_drain(struct rtb_window *win)
+{
+	struct rtb__elem_handle_slot *slot;
+	struct rtb__pending_update *pending;
+	struct rtb_update_queue *queue;
+	struct rtb_update_event ev;
+	struct rtb_element *elem;
+	size_t i;
+
+	if (TAILQ_EMPTY(&win->update_queues))
+		return;
+
+	/* before looking at the queues, so that anything posted while we're
+	 * draining still wakes us up. */
+	__atomic_store_n(&win->updates_need_wakeup, 1, __ATOMIC_SEQ_CST);
+
+	TAILQ_FOREACH(queue, &win->update_queues, entry)
+		drain_queue(win, queue);
+
+	if (!win->pending_updates.size)
+		return;
+
+	for (i = 0; i < win->pending_updates.size; i++) {
+		pending = &win->pending_updates.data[i];
+
+		if ((slot = live_slot(win, pending->update.target)))
+			slot->pending = 0;
+	}
+
+	ev.type = RTB_UPDATE;
+	ev.source = RTB_EVENT_SOURCE_NON_USER;
+	ev.derived_from = NULL;
+
+	/* handlers can remove elements, so look each one up again. */
+	for (i = 0; i < win->pending_updates.size; i++) {
+		pending = &win->pending_updates.data[i];
+
+		if (!(elem = rtb_elem_from_handle(win, pending->update.target)))
+			continue;
+
+		ev.kind = pending->update.kind;
+		ev.value = pending->update.value;
+		rtb_elem_deliver_event(elem, RTB_EVENT(&ev));
+	}
+
+	VECTOR_CLEAR(&win->pending_updates);
+}
+
+void
+rtb__update_init(struct rtb_window *win)
+{
+	VECTOR_INIT(&win->handle_slots, &stdlib_allocator, 16);
+	VECTOR_INIT(&win->pending_updates, &stdlib_allocator, 16);
+	TAILQ_INIT(&win->update_queues);
+
+	win->free_handle = 0;
+	win->updates_need_wakeup = 1;
+}
+
+void
+rtb__update_fini(struct rtb_window *win)
+{
+	struct rtb_update_queue *queue;
+	size_t i;
+
+	while ((queue = TAILQ_FIRST(&win->update_queues)))
+		rtb_update_queue_free(queue);
+
+	/* elements can outlive the window, so their handles can't refer to
+	 * it any more. */
+	for (i = 0; i < win->handle_slots.size; i++) {
+		struct rtb_element *elem = win->handle_slots.data[i].elem;
+
+		if (elem) {
+			elem->handle.index = 0;
+			elem->handle.generation = 0;
+		}
+	}
+
+	VECTOR_FREE(&win->pending_updates);
+	VECTOR_FREE(&win->handle_slots);
+}
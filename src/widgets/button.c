@@ -127,7 +127,7 @@ attached(struct rtb_element *elem,
 	SELF_FROM(elem);
 
 	super.attached(elem, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.widgets.button");
 
 	self->outer_pad.x = self->label.outer_pad.x;
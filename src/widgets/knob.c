@@ -88,7 +88,7 @@ attached(struct rtb_element *elem,
 	SELF_FROM(elem);
 
 	super.attached(elem, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.widgets.knob");
 
 	set_value_hook(elem, NULL);
@@ -102,8 +102,7 @@ restyle(struct rtb_element *elem)
 	const struct rtb_style_property_definition *prop;
 	super.restyle(elem);
 
-	prop = rtb_style_query_prop(elem,
-			"-rtb-knob-rotor", RTB_STYLE_PROP_TEXTURE, 0);
+	prop = rtb_style_computed_prop(elem, RTB_STYLE_PROP_ID_KNOB_ROTOR, 0);
 	if (prop &&
 			!rtb_stylequad_set_background_image(&self->rotor, &prop->texture))
 		rtb_elem_mark_dirty(elem);
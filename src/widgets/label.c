@@ -58,7 +58,7 @@ attached(struct rtb_element *elem,
 	SELF_FROM(elem);
 
 	super.attached(elem, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.widgets.label");
 
 	if (self->cls)
@@ -72,6 +72,8 @@ attached(struct rtb_element *elem,
 	if (!self->tobj)
 		self->tobj = rtb_text_object_new(&window->font_manager);
 
+	self->tobj->shaping = self->shaping;
+
 	self->font = NULL;
 }
 
@@ -84,10 +86,16 @@ size(struct rtb_element *elem,
 	if (!self->tobj) {
 		want->w = 0.f;
 		want->h = 0.f;
-	} else {
-		want->w = ceilf(self->tobj->w);
-		want->h = ceilf(self->tobj->h);
+		return;
 	}
+
+	/* re-breaking the lines only uses cached advances, so it's cheap
+	 * enough to do on every size request. */
+	if (self->overflow != RTB_TEXT_OVERFLOW_VISIBLE)
+		rtb_text_object_constrain(self->tobj, avail->w, self->overflow);
+
+	want->w = ceilf(self->tobj->w);
+	want->h = ceilf(self->tobj->h);
 }
 
 static int
@@ -119,8 +127,8 @@ restyle(struct rtb_element *elem)
 
 	get_style_from = self->cls ? elem : self->parent;
 
-	prop = rtb_style_query_prop_in_tree(get_style_from,
-			"font", RTB_STYLE_PROP_FONT, 0);
+	prop = rtb_style_computed_prop(get_style_from,
+			RTB_STYLE_PROP_ID_FONT, 0);
 
 	assert(prop);
 
@@ -135,8 +143,8 @@ restyle(struct rtb_element *elem)
 				RTB_DIRECTION_ROOTWARD);
 	}
 
-	prop = rtb_style_query_prop_in_tree(get_style_from,
-			"color", RTB_STYLE_PROP_COLOR, 1);
+	prop = rtb_style_computed_prop(get_style_from,
+			RTB_STYLE_PROP_ID_COLOR, 1);
 	self->color = &prop->color;
 }
 
@@ -192,6 +200,8 @@ rtb_label_init(struct rtb_label *self)
 	self->font = NULL;
 
 	self->line_height_multiplier = 1.f;
+	self->overflow = RTB_TEXT_OVERFLOW_VISIBLE;
+	self->shaping = 1;
 	self->cls = NULL;
 
 	return 0;
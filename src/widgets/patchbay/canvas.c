@@ -167,8 +167,8 @@ draw_bg(struct rtb_patchbay *self)
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
 
-	prop = rtb_style_query_prop(RTB_ELEMENT(self),
-			"background-image", RTB_STYLE_PROP_TEXTURE, 1);
+	prop = rtb_style_computed_prop(RTB_ELEMENT(self),
+			RTB_STYLE_PROP_ID_BACKGROUND_IMAGE, 1);
 
 	glBindTexture(GL_TEXTURE_2D, self->bg_texture);
 	glUniform1i(shader.uniform.texture, 0);
@@ -177,8 +177,8 @@ draw_bg(struct rtb_patchbay *self)
 			roundf(self->texture_offset.x),
 			roundf(self->texture_offset.y));
 
-	prop = rtb_style_query_prop(RTB_ELEMENT(self),
-			"color", RTB_STYLE_PROP_COLOR, 1);
+	prop = rtb_style_computed_prop(RTB_ELEMENT(self),
+			RTB_STYLE_PROP_ID_COLOR, 1);
 
 	glUniform4f(shader.uniform.front_color,
 			prop->color.r,
@@ -186,8 +186,8 @@ draw_bg(struct rtb_patchbay *self)
 			prop->color.b,
 			prop->color.a);
 
-	prop = rtb_style_query_prop(RTB_ELEMENT(self),
-			"background-color", RTB_STYLE_PROP_COLOR, 1);
+	prop = rtb_style_computed_prop(RTB_ELEMENT(self),
+			RTB_STYLE_PROP_ID_BACKGROUND_COLOR, 1);
 
 	glUniform4f(shader.uniform.back_color,
 			prop->color.r,
@@ -395,7 +395,7 @@ attached(struct rtb_element *elem,
 	SELF_FROM(elem);
 
 	super.attached(elem, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.widgets.patchbay");
 
 	cache_to_vbo(self);
@@ -411,8 +411,8 @@ restyle(struct rtb_element *elem)
 	old_style = self->style;
 	super.restyle(elem);
 
-	prop = rtb_style_query_prop(RTB_ELEMENT(self),
-			"background-image", RTB_STYLE_PROP_TEXTURE, 0);
+	prop = rtb_style_computed_prop(RTB_ELEMENT(self),
+			RTB_STYLE_PROP_ID_BACKGROUND_IMAGE, 0);
 
 	if (prop)
 		load_tile(&prop->texture, self->bg_texture);
@@ -88,7 +88,7 @@ attached(struct rtb_element *elem,
 	self->patchbay = (struct rtb_patchbay *) parent;
 
 	super.attached(elem, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.widgets.patchbay.node");
 }
 
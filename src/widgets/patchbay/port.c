@@ -215,7 +215,7 @@ attached(struct rtb_element *elem,
 	SELF_FROM(elem);
 
 	super.attached(RTB_ELEMENT(self), parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.widgets.patchbay.port");
 }
 
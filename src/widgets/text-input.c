@@ -309,7 +309,7 @@ attached(struct rtb_element *elem,
 	SELF_FROM(elem);
 
 	super.attached(elem, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.widgets.text-input");
 }
 
@@ -360,7 +360,10 @@ rtb_text_input_set_text(struct rtb_text_input *self,
 		rtb_utf8_t *text, ssize_t nbytes)
 {
 	rtb_text_buffer_set_text(&self->text, text, nbytes);
-	self->cursor_position = u8chars(text);
+
+	/* don't count the trailing NUL */
+	self->cursor_position = rtb__u8_count(self->text.data,
+			self->text.size - 1);
 
 	post_change(self);
 
@@ -382,6 +385,10 @@ rtb_text_input_init(struct rutabaga *rtb, struct rtb_text_input *self)
 	rtb_quad_init(&self->bg_quad);
 
 	rtb_label_init(&self->label);
+
+	/* the cursor is positioned by glyph, so we need one glyph per
+	 * codepoint */
+	self->label.shaping = 0;
 	rtb_elem_add_child(RTB_ELEMENT(self), RTB_ELEMENT(&self->label),
 			RTB_ADD_HEAD);
 
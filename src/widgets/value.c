@@ -53,19 +53,62 @@ static struct rtb_element_implementation super;
  */
 
 static int
-dispatch_value_change_event(struct rtb_value_element *self,
-		const struct rtb_event *derive_from)
+deliver_value_change_event(struct rtb_value_element *self,
+		rtb_ev_source_t source, const struct rtb_event *derive_from)
 {
 	struct rtb_value_change_event event = {
 		.type         = RTB_VALUE_CHANGE,
-		.source       = rtb_event_derived_source(derive_from),
+		.source       = source,
 		.derived_from = derive_from,
-		.value        = self->value
+		.value        = self->value,
+		.merged       = 0
 	};
 
+	/* a pending change is superseded by this one. */
+	if (self->change_pending) {
+		event.merged = self->pending_merged + 1;
+		self->change_pending = 0;
+	}
+
+	self->change_stats.delivered++;
+	self->change_stats.merged += event.merged;
+
 	return rtb_elem_deliver_event(RTB_ELEMENT(self), RTB_EVENT(&event));
 }
 
+static void
+flush_value_change(struct rtb_element *elem)
+{
+	SELF_FROM(elem);
+
+	if (self->change_pending)
+		deliver_value_change_event(self, self->pending_source, NULL);
+}
+
+static int
+dispatch_value_change_event(struct rtb_value_element *self,
+		const struct rtb_event *derive_from)
+{
+	rtb_ev_source_t source = rtb_event_derived_source(derive_from);
+
+	if (!self->coalesce_changes || self->ve_state == RTB_VALUE_STATE_AT_REST)
+		return deliver_value_change_event(self, source, derive_from);
+
+	/* the event we'd derive from won't be around by the next frame, so
+	 * all we keep is where it came from. */
+	if (self->change_pending) {
+		self->pending_merged++;
+	} else {
+		self->change_pending = 1;
+		self->pending_merged = 0;
+		rtb_window_call_next_frame(self->window, RTB_ELEMENT(self),
+				flush_value_change);
+	}
+
+	self->pending_source = source;
+	return 1;
+}
+
 static int
 dispatch_value_delta_event(struct rtb_value_element *self,
 		const struct rtb_event *derive_from, float delta)
@@ -133,6 +176,9 @@ change_state(struct rtb_value_element *self,
 		 * issues like mousewheel during drag prematurely exiting from an
 		 * active state. */
 
+		/* listeners get the final value before they hear that editing
+		 * has finished. */
+		flush_value_change(RTB_ELEMENT(self));
 		self->ve_state = RTB_VALUE_STATE_AT_REST;
 	} else {
 		return 0;
@@ -289,6 +335,21 @@ handle_reset(struct rtb_value_element *self, const struct rtb_event *e)
 	return 1;
 }
 
+static int
+handle_update(struct rtb_value_element *self,
+		const struct rtb_update_event *e)
+{
+	if (e->kind != RTB_UPDATE_VALUE)
+		return 0;
+
+	/* don't fight the user. */
+	if (self->ve_state != RTB_VALUE_STATE_AT_REST)
+		return 1;
+
+	rtb_value_element_set_value(self, RTB_EVENT(e), e->value.f);
+	return 1;
+}
+
 static int
 on_event(struct rtb_element *elem, const struct rtb_event *e)
 {
@@ -324,6 +385,9 @@ on_event(struct rtb_element *elem, const struct rtb_event *e)
 	case RTB_KEY_PRESS:
 		return handle_key(self, RTB_EVENT_AS(e, rtb_key_event));
 
+	case RTB_UPDATE:
+		return handle_update(self, RTB_EVENT_AS(e, rtb_update_event));
+
 	case RTB_DRAG_DROP:
 		if (rtb_elem_is_in_tree(RTB_ELEMENT(self), drag_event->target)
 				&& !(drag_event->start_mod_keys &
@@ -384,6 +448,17 @@ attached(struct rtb_element *elem,
 		rtb__value_element_set_value_uncooked(self, NULL, self->value);
 }
 
+static void
+detached(struct rtb_element *elem,
+		struct rtb_element *parent, struct rtb_window *window)
+{
+	/* once we're out of the window, the flush we asked it for is
+	 * dropped, so deliver any pending change while we still can. */
+	flush_value_change(elem);
+
+	super.detached(elem, parent, window);
+}
+
 /**
  * protected API
  */
@@ -464,6 +539,7 @@ rtb_value_element_init(struct rtb_value_element *self)
 		return -1;
 
 	self->attached = attached;
+	self->detached = detached;
 	self->on_event = on_event;
 
 	self->granularity  =
@@ -478,6 +554,11 @@ rtb_value_element_init(struct rtb_value_element *self)
 	self->ve_state = RTB_VALUE_STATE_AT_REST;
 	self->deny_drag_start_mod_mask = RTB_KEY_MOD_CTRL | RTB_KEY_MOD_ALT;
 
+	self->coalesce_changes = 0;
+	self->change_pending = 0;
+	self->change_stats.delivered = 0;
+	self->change_stats.merged = 0;
+
 	self->delta_mult = 1.f;
 	self->min = 0.f;
 	self->max = 1.f;
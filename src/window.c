@@ -42,7 +42,11 @@
 #include <rutabaga/mat4.h>
 
 #include "rtb_private/util.h"
+#include "rtb_private/stdlib-allocator.h"
 #include "rtb_private/window_impl.h"
+#include "rtb_private/update.h"
+#include "rtb_private/animation.h"
+#include "rtb_private/frame-stats.h"
 
 #include "shaders/default.glsl.h"
 #include "shaders/surface.glsl.h"
@@ -267,7 +271,7 @@ attached(struct rtb_element *elem,
 	SELF_FROM(elem);
 
 	super.attached(elem, parent, window);
-	self->type = rtb_type_ref(window, self->type,
+	self->type = rtb_type_ref_static(window, self->type,
 			"net.illest.rutabaga.window");
 
 	self->overlay_surface.attached(
@@ -275,6 +279,7 @@ attached(struct rtb_element *elem,
 			elem, self);
 
 	rtb_style_resolve_list(self, self->style_list);
+	rtb_style_prefetch_fonts(RTB_ELEMENT(self));
 	self->restyle(RTB_ELEMENT(self));
 }
 
@@ -308,6 +313,7 @@ static void
 mark_dirty(struct rtb_element *elem)
 {
 	elem->window->dirty = 1;
+	rtb__platform_request_frame(elem->window);
 }
 
 /**
@@ -362,12 +368,46 @@ rtb_window_focus_element(struct rtb_window *self, struct rtb_element *focused)
 	self->focus = focused;
 }
 
+static void
+run_frame_calls(struct rtb_window *self)
+{
+	struct rtb_frame_call call;
+	struct rtb_element *elem;
+	size_t i, ncalls;
+
+	/* anything queued from these callbacks waits for the frame after. */
+	ncalls = self->frame_calls.size;
+	if (!ncalls)
+		return;
+
+	for (i = 0; i < ncalls; i++) {
+		call = self->frame_calls.data[i];
+
+		if ((elem = rtb_elem_from_handle(self, call.elem)))
+			call.cb(elem);
+	}
+
+	VECTOR_ERASE_RANGE(&self->frame_calls, 0, ncalls);
+}
+
 int
 rtb_window_draw(struct rtb_window *self, int force_redraw)
 {
 	const struct rtb_style_property_definition *prop;
+	struct rtb_frame_end_event end_ev;
 	struct rtb_window_event ev;
 
+	self->frame_time = uv_hrtime();
+	rtb__frame_stats_begin(&self->frame_stats, self->frame_time);
+
+	/* even if we aren't going to draw, so that the queues don't fill up
+	 * while we're hidden and deferred work doesn't pile up. */
+	rtb__update_drain(self);
+	run_frame_calls(self);
+	rtb__animation_tick(self);
+
+	rtb__frame_stats_mark(&self->frame_stats, RTB_FRAME_PHASE_EVENTS);
+
 	if (self->state == RTB_STATE_UNATTACHED
 			|| self->visibility == RTB_FULLY_OBSCURED)
 		return 0;
@@ -377,13 +417,18 @@ rtb_window_draw(struct rtb_window *self, int force_redraw)
 	ev.window = self;
 	rtb_dispatch_raw(RTB_ELEMENT(self), RTB_EVENT(&ev));
 
+	rtb__frame_stats_mark(&self->frame_stats, RTB_FRAME_PHASE_LAYOUT);
+
 	if (!self->dirty || force_redraw)
 		return 0;
 
+	self->restyled_last_frame = self->restyled;
+	self->restyled = 0;
+
 	glViewport(0, 0, self->phy_size.w, self->phy_size.h);
 
-	prop = rtb_style_query_prop(RTB_ELEMENT(self),
-			"background-color", RTB_STYLE_PROP_COLOR, 1);
+	prop = rtb_style_computed_prop(RTB_ELEMENT(self),
+			RTB_STYLE_PROP_ID_BACKGROUND_COLOR, 1);
 
 	glEnable(GL_DITHER);
 	glEnable(GL_BLEND);
@@ -400,18 +445,46 @@ rtb_window_draw(struct rtb_window *self, int force_redraw)
 	self->draw(RTB_ELEMENT(self));
 	rtb_render_pop(RTB_ELEMENT(self));
 
-	ev.type = RTB_FRAME_END;
-	rtb_dispatch_raw(RTB_ELEMENT(self), RTB_EVENT(&ev));
+	end_ev.type = RTB_FRAME_END;
+	end_ev.source = RTB_EVENT_SOURCE_NON_USER;
+	end_ev.window = self;
+	end_ev.timing = &self->frame_stats.current;
+	end_ev.stats = &self->frame_stats;
+	rtb_dispatch_raw(RTB_ELEMENT(self), RTB_EVENT(&end_ev));
 
 	rtb_render_push(RTB_ELEMENT(self));
 	self->overlay_surface.draw(RTB_ELEMENT(&self->overlay_surface));
 	rtb_render_pop(RTB_ELEMENT(self));
 
+	rtb__frame_stats_mark(&self->frame_stats, RTB_FRAME_PHASE_DRAW);
+	rtb__frame_stats_drawn(&self->frame_stats, self->restyled_last_frame);
+
 	self->dirty = !TAILQ_EMPTY(&self->render_queue);
+	if (self->dirty)
+		rtb__platform_request_frame(self);
 
 	return 1;
 }
 
+void
+rtb_window_request_frame(struct rtb_window *self)
+{
+	rtb__platform_request_frame(self);
+}
+
+void
+rtb_window_call_next_frame(struct rtb_window *self, struct rtb_element *elem,
+		rtb_frame_cb_t cb)
+{
+	struct rtb_frame_call call = {
+		.elem = rtb_elem_get_handle(elem),
+		.cb   = cb
+	};
+
+	VECTOR_PUSH_BACK(&self->frame_calls, &call);
+	rtb__platform_request_frame(self);
+}
+
 void
 rtb_window_reinit(struct rtb_window *self)
 {
@@ -496,6 +569,7 @@ rtb_window_open(struct rutabaga *r, const struct rtb_window_open_options *opt)
 	stdata = rtb_style_get_defaults();
 	self->style_list = stdata.style;
 	self->style_fonts = calloc(stdata.nfonts, sizeof(*self->style_fonts));
+	self->style_prop_names = stdata.prop_names;
 
 	if (shaders_init(self))
 		goto err_shaders;
@@ -507,6 +581,8 @@ rtb_window_open(struct rutabaga *r, const struct rtb_window_open_options *opt)
 				self->dpi.x, self->dpi.y))
 		goto err_font;
 
+	self->font_manager.loop = &r->event_loop;
+
 	rtb_elem_set_layout(RTB_ELEMENT(self), rtb_layout_vpack_top);
 
 	self->on_event   = win_event;
@@ -539,6 +615,12 @@ rtb_window_open(struct rutabaga *r, const struct rtb_window_open_options *opt)
 
 	self->dpi_changed = 0;
 	self->mouse.current_cursor = RTB_MOUSE_CURSOR_DEFAULT;
+	VECTOR_INIT(&self->mouse.motion_history, &stdlib_allocator, 16);
+	rtb__update_init(self);
+	VECTOR_INIT(&self->frame_calls, &stdlib_allocator, 8);
+	TAILQ_INIT(&self->animations);
+	TAILQ_INIT(&self->finishing_animations);
+	rtb__frame_stats_init(&self->frame_stats);
 	return self;
 
 err_font:
@@ -569,6 +651,11 @@ rtb_window_close(struct rtb_window *self)
 
 	free(self->style_fonts);
 	free(self->style_list);
+	free(self->type_styles);
+
+	VECTOR_FREE(&self->mouse.motion_history);
+	VECTOR_FREE(&self->frame_calls);
+	rtb__update_fini(self);
 
 	rtb_surface_fini(RTB_SURFACE(self));
 	window_impl_close(self);
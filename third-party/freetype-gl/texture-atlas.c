@@ -68,6 +68,7 @@ texture_atlas_new( const size_t width,
     self->height = height;
     self->depth = depth;
     self->id = 0;
+    self->dirty = 1;
 
     self->dpi.x = x_dpi;
     self->dpi.y = y_dpi;
@@ -134,6 +135,8 @@ texture_atlas_set_region( texture_atlas_t * self,
         memcpy( self->data+((y+i)*self->width + x ) * charsize * depth,
                 data + (i*stride) * charsize, width * charsize * depth  );
     }
+
+    self->dirty = 1;
 }
 
 
@@ -307,6 +310,7 @@ texture_atlas_clear( texture_atlas_t * self )
 
     vector_push_back( self->nodes, &node );
     memset( self->data, 0, self->width*self->height*self->depth );
+    self->dirty = 1;
 }
 
 
@@ -347,6 +351,8 @@ texture_atlas_upload( texture_atlas_t * self )
         glTexImage2D( GL_TEXTURE_2D, 0, GL_RED, self->width, self->height,
                       0, GL_RED, GL_UNSIGNED_BYTE, self->data );
     }
+
+    self->dirty = 0;
 }
 
 /* vim: set expandtab sw=4 ts=4 :*/
@@ -133,6 +133,11 @@ typedef struct
      */
     unsigned int id;
 
+    /**
+     * Whether data has changed since the last upload
+     */
+    int dirty;
+
     /**
      * Atlas data
      */
@@ -170,7 +175,9 @@ typedef struct
 
 
 /**
- *  Upload atlas to video memory.
+ *  Upload atlas to video memory. Regions are only written to system
+ *  memory, so this needs to be called before rendering if the atlas is
+ *  dirty.
  *
  *  @param self a texture atlas structure
  *
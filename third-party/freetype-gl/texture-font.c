@@ -167,6 +167,30 @@ texture_font_get_hires_face(texture_font_t *self,
 			self, self->size, library, face);
 }
 
+int
+texture_font_get_shaping_face(texture_font_t *self,
+		FT_Library *library, FT_Face *face)
+{
+	FT_Error error;
+
+	if (!texture_font_get_face(self, library, face))
+		return 0;
+
+	error = FT_Set_Char_Size(*face, convert_float_to_F26Dot6(self->size), 0,
+			self->atlas->dpi.x, self->atlas->dpi.y);
+
+	if (error) {
+		fprintf(stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
+				__LINE__, FT_Errors[error].code, FT_Errors[error].message);
+		FT_Done_Face(*face);
+		FT_Done_FreeType(*library);
+		return 0;
+	}
+
+	FT_Set_Transform(*face, NULL, NULL);
+	return 1;
+}
+
 // ------------------------------------------------------ texture_glyph_new ---
 texture_glyph_t *
 texture_glyph_new(void)
@@ -247,9 +271,14 @@ texture_font_generate_kerning(texture_font_t *self)
     for( i=1; i<self->glyphs->size; ++i )
     {
         glyph = *(texture_glyph_t **) vector_get( self->glyphs, i );
-        glyph_index = FT_Get_Char_Index( face, glyph->charcode );
         vector_clear( glyph->kerning );
 
+        /* shaped glyphs get their kerning from the shaper */
+        if( glyph->charcode & TEXTURE_FONT_GLYPH_INDEX )
+            continue;
+
+        glyph_index = FT_Get_Char_Index( face, glyph->charcode );
+
         for( j=1; j<self->glyphs->size; ++j )
         {
             prev_glyph = *(texture_glyph_t **) vector_get( self->glyphs, j );
@@ -307,6 +336,8 @@ texture_font_init(texture_font_t *self)
 	self->lcd_weights[3] = 0x40;
 	self->lcd_weights[4] = 0x10;
 
+	self->gamma = 1.0;
+
 	/* Get font metrics at high resolution */
 	if (!texture_font_get_hires_face(self, &library, &face))
 		return -1;
@@ -420,6 +451,105 @@ texture_font_delete(texture_font_t *self)
     free(self);
 }
 
+// ------------------------------------------------- texture_font_add_glyph ---
+texture_glyph_t *
+texture_font_add_glyph( texture_font_t * self,
+                        const texture_glyph_t * metrics,
+                        const unsigned char * bitmap,
+                        size_t stride )
+{
+    size_t width, height, x, y;
+    texture_glyph_t *glyph;
+    ivec4 region;
+
+    assert( self );
+    assert( metrics );
+
+    width  = self->atlas->width;
+    height = self->atlas->height;
+
+    // We want each glyph to be separated by at least one black pixel
+    // (for example for shader used in demo-subpixel.c)
+    region = texture_atlas_get_region( self->atlas,
+                                       metrics->width + 1, metrics->height + 1 );
+    if ( region.x < 0 )
+    {
+        fprintf( stderr, "Texture atlas is full (line %d)\n",  __LINE__ );
+        return NULL;
+    }
+
+    x = region.x;
+    y = region.y;
+    texture_atlas_set_region( self->atlas, x, y,
+                              metrics->width, metrics->height,
+                              bitmap, stride );
+
+    glyph = texture_glyph_new();
+    if( !glyph )
+        return NULL;
+
+    glyph->charcode  = metrics->charcode;
+    glyph->width     = metrics->width;
+    glyph->height    = metrics->height;
+    glyph->outline_type = self->outline_type;
+    glyph->outline_thickness = self->outline_thickness;
+    glyph->offset_x  = metrics->offset_x;
+    glyph->offset_y  = metrics->offset_y;
+    glyph->advance_x = metrics->advance_x;
+    glyph->advance_y = metrics->advance_y;
+    glyph->s0        = x/(float)width;
+    glyph->t0        = y/(float)height;
+    glyph->s1        = (x + glyph->width)/(float)width;
+    glyph->t1        = (y + glyph->height)/(float)height;
+
+    vector_push_back( self->glyphs, &glyph );
+    return glyph;
+}
+
+
+// ------------------------------------------------------ build_gamma_table ---
+static int
+build_gamma_table( float gamma, unsigned char table[256] )
+{
+    int i;
+
+    if( gamma <= 0.0 || gamma == 1.0 )
+        return 0;
+
+    for( i = 0; i < 256; ++i )
+        table[i] = (unsigned char)
+            lroundf( powf( i / 255.f, 1.f / gamma ) * 255.f );
+
+    return 1;
+}
+
+// ------------------------------------------------------------ apply_gamma ---
+static const unsigned char *
+apply_gamma( const unsigned char table[256],
+             const unsigned char * bitmap, size_t row_size, size_t rows,
+             size_t pitch, unsigned char ** scratch, size_t * scratch_size )
+{
+    unsigned char *dst;
+    size_t x, y;
+
+    if( *scratch_size < row_size * rows )
+    {
+        dst = realloc( *scratch, row_size * rows );
+        if( !dst )
+            return NULL;
+
+        *scratch = dst;
+        *scratch_size = row_size * rows;
+    }
+
+    dst = *scratch;
+    for( y = 0; y < rows; ++y )
+        for( x = 0; x < row_size; ++x )
+            dst[y * row_size + x] = table[bitmap[y * pitch + x]];
+
+    return dst;
+}
+
 // ----------------------------------------------- texture_font_load_glyphs ---
 static size_t
 i32len(const int32_t *s)
@@ -431,10 +561,12 @@ i32len(const int32_t *s)
 }
 
 size_t
-texture_font_load_glyphs( texture_font_t * self,
-                          const int32_t * charcodes )
+texture_font_render_glyphs( texture_font_t * self,
+                            const int32_t * charcodes,
+                            texture_font_render_cb callback,
+                            void * ctx )
 {
-    size_t i, x, y, width, height, depth, w, h;
+    size_t i, depth;
     FT_Library library;
     FT_Error error;
     FT_Face face;
@@ -443,22 +575,28 @@ texture_font_load_glyphs( texture_font_t * self,
     FT_Bitmap ft_bitmap;
 
     FT_UInt glyph_index;
-    texture_glyph_t *glyph;
-    ivec4 region;
+    texture_glyph_t metrics;
     size_t missed = 0, len;
 
+    const unsigned char *bitmap;
+    unsigned char gamma_table[256];
+    unsigned char *scratch = NULL;
+    size_t scratch_size = 0, stride;
+    int use_gamma;
+
     assert( self );
     assert( charcodes );
+    assert( callback );
 
 
-    width  = self->atlas->width;
-    height = self->atlas->height;
     depth  = self->atlas->depth;
 	len = i32len(charcodes);
 
 	if (!texture_font_get_face(self, &library, &face))
 		return len;
 
+    use_gamma = build_gamma_table( self->gamma, gamma_table );
+
     /* Load each glyph */
     for( i=0; charcodes[i]; ++i )
     {
@@ -468,7 +606,18 @@ texture_font_load_glyphs( texture_font_t * self,
         int ft_bitmap_pitch = 0;
         int ft_glyph_top = 0;
         int ft_glyph_left = 0;
-        glyph_index = FT_Get_Char_Index( face, charcodes[i] );
+        if( charcodes[i] & TEXTURE_FONT_GLYPH_INDEX )
+            glyph_index = charcodes[i] & ~TEXTURE_FONT_GLYPH_INDEX;
+        else
+            glyph_index = FT_Get_Char_Index( face, charcodes[i] );
+
+        // Discard hinting to get advance. This has to happen before the
+        // glyph is rendered for real, since it replaces the slot's bitmap.
+        FT_Load_Glyph( face, glyph_index, FT_LOAD_RENDER | FT_LOAD_NO_HINTING);
+        slot = face->glyph;
+        metrics.advance_x = convert_F26Dot6_to_float(slot->advance.x);
+        metrics.advance_y = convert_F26Dot6_to_float(slot->advance.y);
+
         // WARNING: We use texture-atlas depth to guess if user wants
         //          LCD subpixel rendering
 
@@ -511,6 +660,7 @@ texture_font_load_glyphs( texture_font_t * self,
             fprintf( stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
                      __LINE__, FT_Errors[error].code, FT_Errors[error].message );
             FT_Done_Face( face );
+            free( scratch );
             FT_Done_FreeType( library );
             return len - i;
         }
@@ -537,6 +687,7 @@ texture_font_load_glyphs( texture_font_t * self,
                         FT_Errors[error].code, FT_Errors[error].message);
                 FT_Done_Face( face );
                 FT_Stroker_Done( stroker );
+                free( scratch );
                 FT_Done_FreeType( library );
                 return 0;
             }
@@ -552,6 +703,7 @@ texture_font_load_glyphs( texture_font_t * self,
                         FT_Errors[error].code, FT_Errors[error].message);
                 FT_Done_Face( face );
                 FT_Stroker_Done( stroker );
+                free( scratch );
                 FT_Done_FreeType( library );
                 return 0;
             }
@@ -574,6 +726,7 @@ texture_font_load_glyphs( texture_font_t * self,
                         FT_Errors[error].code, FT_Errors[error].message);
                 FT_Done_Face( face );
                 FT_Stroker_Done( stroker );
+                free( scratch );
                 FT_Done_FreeType( library );
                 return 0;
             }
@@ -587,6 +740,7 @@ texture_font_load_glyphs( texture_font_t * self,
                             FT_Errors[error].code, FT_Errors[error].message);
                     FT_Done_Face( face );
                     FT_Stroker_Done( stroker );
+                    free( scratch );
                     FT_Done_FreeType( library );
                     return 0;
                 }
@@ -600,6 +754,7 @@ texture_font_load_glyphs( texture_font_t * self,
                             FT_Errors[error].code, FT_Errors[error].message);
                     FT_Done_Face( face );
                     FT_Stroker_Done( stroker );
+                    free( scratch );
                     FT_Done_FreeType( library );
                     return 0;
                 }
@@ -615,50 +770,25 @@ texture_font_load_glyphs( texture_font_t * self,
         }
 
 
-        // We want each glyph to be separated by at least one black pixel
-        // (for example for shader used in demo-subpixel.c)
-        w = ft_bitmap_width/depth + 1;
-        h = ft_bitmap_rows + 1;
-        region = texture_atlas_get_region( self->atlas, w, h );
-        if ( region.x < 0 )
+        metrics.charcode = charcodes[i];
+        metrics.width    = ft_bitmap_width/depth;
+        metrics.height   = ft_bitmap_rows;
+        metrics.offset_x = ft_glyph_left;
+        metrics.offset_y = ft_glyph_top;
+
+        bitmap = ft_bitmap.buffer;
+        stride = ft_bitmap.pitch;
+
+        if( use_gamma && ft_bitmap_rows )
         {
-            missed++;
-            fprintf( stderr, "Texture atlas is full (line %d)\n",  __LINE__ );
-            continue;
+            bitmap = apply_gamma( gamma_table, ft_bitmap.buffer,
+                                  ft_bitmap_width, ft_bitmap_rows,
+                                  ft_bitmap.pitch, &scratch, &scratch_size );
+            stride = ft_bitmap_width;
         }
-        w = w - 1;
-        h = h - 1;
-        x = region.x;
-        y = region.y;
-        texture_atlas_set_region( self->atlas, x, y, w, h,
-                                  ft_bitmap.buffer, ft_bitmap.pitch );
-
-        glyph = texture_glyph_new();
-
-		if (!glyph) {
-			missed = len - i;
-			break;
-		}
-
-        glyph->charcode = charcodes[i];
-        glyph->width    = w;
-        glyph->height   = h;
-        glyph->outline_type = self->outline_type;
-        glyph->outline_thickness = self->outline_thickness;
-        glyph->offset_x = ft_glyph_left;
-        glyph->offset_y = ft_glyph_top;
-        glyph->s0       = x/(float)width;
-        glyph->t0       = y/(float)height;
-        glyph->s1       = (x + glyph->width)/(float)width;
-        glyph->t1       = (y + glyph->height)/(float)height;
-
-        // Discard hinting to get advance
-        FT_Load_Glyph( face, glyph_index, FT_LOAD_RENDER | FT_LOAD_NO_HINTING);
-        slot = face->glyph;
-        glyph->advance_x = convert_F26Dot6_to_float(slot->advance.x);
-        glyph->advance_y = convert_F26Dot6_to_float(slot->advance.y);
 
-        vector_push_back( self->glyphs, &glyph );
+        if( !bitmap || callback( ctx, &metrics, bitmap, stride ) )
+            missed++;
 
         if( self->outline_type > 0 )
         {
@@ -668,30 +798,67 @@ texture_font_load_glyphs( texture_font_t * self,
 		((void) ft_bitmap_pitch); /* shut up, gcc */
     }
 
+    free( scratch );
     FT_Done_Face( face );
     FT_Done_FreeType( library );
-    texture_atlas_upload( self->atlas );
+    return missed;
+}
+
+static int
+add_rendered_glyph( void * ctx,
+                    const texture_glyph_t * metrics,
+                    const unsigned char * bitmap,
+                    size_t stride )
+{
+    return !texture_font_add_glyph( (texture_font_t *) ctx,
+                                    metrics, bitmap, stride );
+}
+
+size_t
+texture_font_load_glyphs( texture_font_t * self,
+                          const int32_t * charcodes )
+{
+    size_t missed;
+
+    missed = texture_font_render_glyphs( self, charcodes,
+                                         add_rendered_glyph, self );
     texture_font_generate_kerning( self );
     return missed;
 }
 
 
-// ------------------------------------------------- texture_font_get_glyph ---
-texture_glyph_t *
-texture_font_get_glyph( texture_font_t * self,
+// ------------------------------------------------- texture_font_has_glyph ---
+int
+texture_font_has_glyph( texture_font_t * self,
                         int32_t charcode )
 {
-    size_t i;
-    int32_t buffer[2] = {0,0};
-    texture_glyph_t *glyph;
+    FT_Library library;
+    FT_Face face;
+    int ret;
 
     assert( self );
 
+    if( !texture_font_get_face( self, &library, &face ) )
+        return 0;
+
+    ret = FT_Get_Char_Index( face, charcode ) != 0;
+
+    FT_Done_Face( face );
+    FT_Done_FreeType( library );
+    return ret;
+}
+
+
+// ------------------------------------------------ texture_font_find_glyph ---
+texture_glyph_t *
+texture_font_find_glyph( texture_font_t * self,
+                         int32_t charcode )
+{
+    size_t i;
+    texture_glyph_t *glyph;
+
     assert( self );
-    assert( self->filename );
-    assert( self->atlas );
 
-    /* Check if charcode has been already loaded */
     for( i=0; i<self->glyphs->size; ++i )
     {
         glyph = *(texture_glyph_t **) vector_get( self->glyphs, i );
@@ -705,6 +872,26 @@ texture_font_get_glyph( texture_font_t * self,
         }
     }
 
+    return NULL;
+}
+
+
+// ------------------------------------------------- texture_font_get_glyph ---
+texture_glyph_t *
+texture_font_get_glyph( texture_font_t * self,
+                        int32_t charcode )
+{
+    int32_t buffer[2] = {0,0};
+    texture_glyph_t *glyph;
+
+    assert( self );
+    assert( self->filename );
+    assert( self->atlas );
+
+    /* Check if charcode has been already loaded */
+    if( (glyph = texture_font_find_glyph( self, charcode )) )
+        return glyph;
+
     /* charcode -1 is special : it is used for line drawing (overline,
      * underline, strikethrough) and background.
      */
@@ -284,6 +284,12 @@ typedef struct
      */
     unsigned char lcd_weights[5];
 
+    /**
+     * Gamma applied to coverage values as glyphs are rasterized, so that
+     * the fragment shader doesn't have to. 1.0 leaves them untouched.
+     */
+    float gamma;
+
     /**
      * This field is simply used to compute a default line spacing (i.e., the
      * baseline-to-baseline distance) when writing text with this font. Note
@@ -383,6 +389,124 @@ typedef struct
                           int32_t charcode );
 
 
+/**
+ * Look up a glyph that has already been loaded, without loading it if it
+ * hasn't.
+ *
+ * @param self     A valid texture font
+ * @param charcode Character codepoint to look up.
+ *
+ * @return A pointer on the glyph or 0 if it isn't loaded
+ *
+ */
+  texture_glyph_t *
+  texture_font_find_glyph( texture_font_t * self,
+                           int32_t charcode );
+
+
+/**
+ * Add an already rasterized glyph to the font, copying its bitmap into the
+ * texture atlas. Only the charcode, size, offset and advance of `metrics`
+ * are used; texture coordinates are filled in from where it lands in the
+ * atlas.
+ *
+ * @param self     A valid texture font
+ * @param metrics  Glyph metrics
+ * @param bitmap   metrics->height rows of metrics->width pixels, each
+ *                 atlas->depth bytes
+ * @param stride   Distance between rows of bitmap, in bytes
+ *
+ * @return A pointer on the new glyph or 0 if the texture atlas is full
+ *
+ */
+  texture_glyph_t *
+  texture_font_add_glyph( texture_font_t * self,
+                          const texture_glyph_t * metrics,
+                          const unsigned char * bitmap,
+                          size_t stride );
+
+
+/**
+ * OR'd into a charcode to request a glyph by its index in the face rather
+ * than by codepoint, for glyphs that come out of a shaper.
+ */
+#define TEXTURE_FONT_GLYPH_INDEX 0x40000000
+
+/**
+ * Check whether the font's charmap has a glyph for a codepoint. This loads
+ * the face, so callers should cache the result.
+ *
+ * @param self     A valid texture font
+ * @param charcode Character codepoint to check.
+ *
+ * @return 1 if the font has the glyph, 0 if it would be .notdef
+ */
+  int
+  texture_font_has_glyph( texture_font_t * self,
+                          int32_t charcode );
+
+
+/**
+ * Load the font's face for use by a shaper. Unlike the faces used for
+ * rasterisation, this one has no horizontal oversampling, so metrics come
+ * out in pixels at the atlas DPI.
+ *
+ * The caller owns both the face and the library, and should release them
+ * with FT_Done_Face() and FT_Done_FreeType().
+ *
+ * Only declared if FreeType's headers have been included first, so that
+ * users of this header don't need them.
+ *
+ * @return 1 on success, 0 on failure
+ */
+#ifdef FT_FREETYPE_H
+  int
+  texture_font_get_shaping_face( texture_font_t * self,
+                                 FT_Library * library,
+                                 FT_Face * face );
+#endif
+
+
+/**
+ * Called by texture_font_render_glyphs() with each glyph it rasterizes.
+ * `bitmap` is only valid for the duration of the call.
+ *
+ * @return 0 if the glyph was taken, anything else to count it as missed
+ */
+typedef int (*texture_font_render_cb)( void * ctx,
+                                       const texture_glyph_t * metrics,
+                                       const unsigned char * bitmap,
+                                       size_t stride );
+
+/**
+ * Rasterize glyphs without touching the texture atlas or the font's glyph
+ * list, handing each one to `callback` instead. This only reads from the
+ * font, so it can run on another thread as long as nothing else modifies
+ * the font in the meantime.
+ *
+ * @param self       A valid texture font
+ * @param charcodes  Character codepoints to be rendered, 0-terminated
+ * @param callback   Called with the metrics and bitmap of each glyph
+ * @param ctx        Passed through to callback
+ *
+ * @return Number of glyphs that could not be rendered or were refused
+ */
+  size_t
+  texture_font_render_glyphs( texture_font_t * self,
+                              const int32_t * charcodes,
+                              texture_font_render_cb callback,
+                              void * ctx );
+
+
+/**
+ * Compute kerning between every pair of glyphs the font has loaded.
+ *
+ * @param self A valid texture font
+ */
+  void
+  texture_font_generate_kerning( texture_font_t * self );
+
+
 /**
  * Request the loading of several glyphs at once.
  *
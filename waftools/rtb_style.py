@@ -25,7 +25,8 @@ def do_css2c(task):
         copyright + css2c_prelude
         + ("extern const struct rtb_style {var_name}[];\n"
            "extern const size_t {var_name}_size;\n"
-           "extern const size_t {var_name}_fonts;\n").format(var_name=var_name))
+           "extern const size_t {var_name}_fonts;\n"
+           "extern const char *const {var_name}_props[];\n").format(var_name=var_name))
 
     output_file(".c").write(
         copyright + css2c_prelude
@@ -33,7 +34,9 @@ def do_css2c(task):
         + "const struct rtb_style {var_name}[] = ".format(var_name=var_name)
         + stylesheet.c_repr(var_name)
         + "\n\nconst size_t {var_name}_size = sizeof({var_name});".format(var_name=var_name)
-        + "\nconst size_t {var_name}_fonts = {fonts_used};".format(var_name=var_name, fonts_used = stylesheet.fonts_used))
+        + "\nconst size_t {var_name}_fonts = {fonts_used};".format(var_name=var_name, fonts_used = stylesheet.fonts_used)
+        + "\n\nconst char *const {var_name}_props[] = ".format(var_name=var_name)
+        + stylesheet.c_prop_names())
 
 ####
 # bin2c
@@ -0,0 +1,64 @@
+# rutabaga: an OpenGL widget toolkit
+# Copyright (c) 2013-2018 William Light.
+# All rights reserved.
+#
+# This is free and unencumbered software released into the public domain.
+#
+# Anyone is free to copy, modify, publish, use, compile, sell, or
+# distribute this software, either in source code form or as a compiled
+# binary, for any purpose, commercial or non-commercial, and by any
+# means.
+#
+# In jurisdictions that recognize copyright laws, the author or authors
+# of this software dedicate any and all copyright interest in the
+# software to the public domain. We make this dedication for the benefit
+# of the public at large and to the detriment of our heirs and
+# successors. We intend this dedication to be an overt act of
+# relinquishment in perpetuity of all present and future rights to this
+# software under copyright law.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# For more information, please refer to <http://unlicense.org/>
+
+from rutabaga_css.prop import RutabagaStyleProperty
+from rutabaga_css.parser import ParseError
+
+all = [
+    'RutabagaEasingProperty']
+
+# rtb_easing_t in include/rutabaga/animation.h
+easing_mapping = {
+    'linear':      'RTB_EASE_LINEAR',
+    'ease-in':     'RTB_EASE_IN',
+    'ease-out':    'RTB_EASE_OUT',
+    'ease-in-out': 'RTB_EASE_IN_OUT',
+
+    # close enough
+    'ease':        'RTB_EASE_OUT'}
+
+class RutabagaEasingProperty(RutabagaStyleProperty):
+    def __init__(self, stylesheet, name, tokens):
+        self.name  = name
+        self.value = None
+
+        tok = tokens[0]
+
+        if tok.type != 'IDENT' or tok.value not in easing_mapping:
+            raise ParseError(tok, 'expected one of {0}'.format(
+                ', '.join(sorted(easing_mapping))))
+
+        self.value = easing_mapping[tok.value]
+
+    c_repr_tpl = """\
+\t\t\t\t\t.type = RTB_STYLE_PROP_INT,
+\t\t\t\t\t.i = {val}"""
+
+    def c_repr(self):
+        return self.c_repr_tpl.format(val=self.value)
@@ -31,7 +31,8 @@ from rutabaga_css.prop import RutabagaStyleProperty
 from rutabaga_css.parser import ParseError
 
 all = [
-    'RutabagaFloatProperty']
+    'RutabagaFloatProperty',
+    'RutabagaTimeProperty']
 
 class RutabagaFloatProperty(RutabagaStyleProperty):
     def __init__(self, stylesheet, name, tokens):
@@ -54,3 +55,22 @@ class RutabagaFloatProperty(RutabagaStyleProperty):
 
     def c_repr(self):
         return self.c_repr_tpl.format(val=self.value)
+
+class RutabagaTimeProperty(RutabagaFloatProperty):
+    # stored in seconds
+    units = {
+        's':  1.0,
+        'ms': 0.001}
+
+    def __init__(self, stylesheet, name, tokens):
+        self.name  = name
+        self.value = None
+
+        tok = tokens[0]
+
+        if tok.type == 'DIMENSION' and tok.unit in self.units:
+            self.value = tok.value * self.units[tok.unit]
+        elif tok.type == 'INTEGER' and tok.value == 0:
+            self.value = 0
+        else:
+            raise ParseError(tok, 'expected a time in s or ms')
@@ -35,7 +35,8 @@ all = [
 
 class RutabagaFontProperty(RutabagaStyleProperty):
     def __init__(self, stylesheet, name,
-            family=None, weight=None, size=None, gamma=2.2):
+            family=None, fallbacks=[], weight=None, size=None, gamma=2.2,
+            antialias=None):
         self.stylesheet = stylesheet
 
         if not family:
@@ -46,23 +47,59 @@ class RutabagaFontProperty(RutabagaStyleProperty):
         self.size   = size or 12
         self.gamma  = gamma
 
+        antialias = antialias or 'lcd'
+        if antialias not in self.antialias_modes:
+            raise Exception(
+                    'unknown -rtb-font-antialias "{0}"'.format(antialias))
+
+        self.antialias = self.antialias_modes[antialias]
+
         self.slot = stylesheet.fonts_used
         stylesheet.fonts_used += 1
 
         font = self.stylesheet.fonts[self.family]
         self.font_ref = font.use_weight(self.weight)
 
+        self.fallback_refs = []
+
+        for fallback in fallbacks:
+            if fallback not in self.stylesheet.fonts:
+                raise Exception(
+                        'no @font-face for fallback "{0}"'.format(fallback))
+
+            font = self.stylesheet.fonts[fallback]
+            self.fallback_refs.append(font.use_weight(
+                self.weight if self.weight in font.weights else None))
+
+    antialias_modes = {
+        'lcd': 'RTB_FONT_ANTIALIAS_LCD',
+        'grayscale': 'RTB_FONT_ANTIALIAS_GRAYSCALE'}
+
     c_repr_tpl = """\
 \t\t\t\t\t.type = RTB_STYLE_PROP_FONT,
 \t\t\t\t\t.font = {{
-\t\t\t\t\t\t.face = &{face_var},
+\t\t\t\t\t\t.face = &{face_var},{fallbacks}
 \t\t\t\t\t\t.size = {size},
 \t\t\t\t\t\t.slot = {slot},
+\t\t\t\t\t\t.antialias = {antialias},
 \t\t\t\t\t\t.lcd_gamma = {gamma}}}"""
 
+    c_fallbacks_tpl = """
+\t\t\t\t\t\t.fallbacks = (const struct rtb_style_font_face *const []) {{
+\t\t\t\t\t\t\t{faces}, NULL}},"""
+
     def c_repr(self):
+        fallbacks = ""
+
+        if self.fallback_refs:
+            fallbacks = self.c_fallbacks_tpl.format(
+                    faces=", ".join(["&" + f.descriptor_var
+                        for f in self.fallback_refs]))
+
         return self.c_repr_tpl.format(
                 face_var=self.font_ref.descriptor_var,
+                fallbacks=fallbacks,
                 gamma=self.gamma,
+                antialias=self.antialias,
                 size=self.size,
                 slot=self.slot)
@@ -35,6 +35,7 @@ from rutabaga_css.properties.rgba import *
 from rutabaga_css.properties.texture import *
 from rutabaga_css.properties.font import *
 from rutabaga_css.properties.float import *
+from rutabaga_css.properties.easing import *
 
 all = ['RutabagaStyle']
 
@@ -59,6 +60,9 @@ prop_mapping = {
     'min-width':  RutabagaFloatProperty,
     'min-height': RutabagaFloatProperty,
 
+    'transition-duration': RutabagaTimeProperty,
+    'transition-timing-function': RutabagaEasingProperty,
+
     ####
     # unabashedly nonstandard props
     ####
@@ -66,6 +70,22 @@ prop_mapping = {
     '-rtb-knob-rotor': RutabagaTextureProperty,
 }
 
+# properties the toolkit queries itself. these get fixed IDs, in this
+# order, which have to match rtb_style_prop_id_t in
+# include/rutabaga/computed-style.h. anything else gets an ID after them.
+builtin_props = [
+    'color',
+    'background-color',
+    'background-image',
+    'border-image',
+    'border-color',
+    'min-width',
+    'min-height',
+    'font',
+    '-rtb-knob-rotor',
+    'transition-duration',
+    'transition-timing-function']
+
 prop_suffix_mapping = {
     'color': RutabagaRGBAProperty,
     'image': RutabagaTextureProperty,
@@ -79,13 +99,20 @@ class RutabagaStyleState(object):
 
         self.font_descriptor = {
             'family': None,
+            'fallbacks': [],
             'weight': None,
             'size':   None,
-            'gamma':  2.2}
+            'gamma':  2.2,
+            'antialias': None}
 
     def parse_font_tokens(self, prop, tokens):
         if prop == 'font-family':
-            self.font_descriptor['family'] = tokens[0].value
+            # `font-family: "first choice", "fallback", ...`
+            families = [t.value for t in tokens
+                    if t.type in ('STRING', 'IDENT')]
+
+            self.font_descriptor['family'] = families[0]
+            self.font_descriptor['fallbacks'] = families[1:]
         elif prop == 'font-size':
             # XXX: disregarding unit
             self.font_descriptor['size'] = tokens[0].value
@@ -93,13 +120,18 @@ class RutabagaStyleState(object):
             self.font_descriptor['weight'] = tokens[0].value
         elif prop == '-rtb-font-lcd-gamma':
             self.font_descriptor['gamma'] = tokens[0].value
+        elif prop == '-rtb-font-antialias':
+            # `lcd` (the default) or `grayscale`
+            self.font_descriptor['antialias'] = tokens[0].value
 
     def add_prop(self, prop, tokens):
         if prop in ('font-family', 'font-weight',
-                'font-size', '-rtb-font-lcd-gamma'):
+                'font-size', '-rtb-font-lcd-gamma', '-rtb-font-antialias'):
             self.parse_font_tokens(prop, tokens)
             return
 
+        self.stylesheet.prop_id(prop)
+
         try:
             self.props[prop] = \
                     prop_mapping[prop](self.stylesheet, prop, tokens)
@@ -119,6 +151,9 @@ class RutabagaStyleState(object):
     c_empty_state_repr = '''\
 \t\t\t[{state}] = (const struct rtb_style_property_definition []) {{{{NULL}}}}'''
 
+    c_index_repr = '''\
+\t\t\t[{state}] = (const uint8_t [{nprops}]) {{{indices}}}'''
+
     c_prop_repr = '''\
 \t\t\t\t{{"{0}",
 {1}}}'''
@@ -128,6 +163,18 @@ class RutabagaStyleState(object):
             self.props['font'] = RutabagaFontProperty(self.stylesheet,
                     'font', **self.font_descriptor)
 
+    def c_index(self, state_name):
+        # 1 + the property's position in the state's property array,
+        # indexed by property ID. 0 means "not set in this state".
+        indices = ', '.join(
+            ['[{0}] = {1}'.format(self.stylesheet.prop_id(name), i + 1)
+                for (i, name) in enumerate(self.props)]) or '0'
+
+        return self.c_index_repr.format(
+            state=state_mapping[state_name],
+            nprops=len(self.stylesheet.prop_ids),
+            indices=indices)
+
     def c_repr(self, state_name):
         if not self.props:
             return self.c_empty_state_repr.format(
@@ -173,6 +220,10 @@ class RutabagaStyle(object):
 \t\t.resolved_type = NULL,
 \t\t.properties = {{
 {state_definitions}
+\t\t}},
+\t\t.nprops = {nprops},
+\t\t.prop_index = {{
+{state_indices}
 \t\t}}
 \t}}"""
 
@@ -181,4 +232,8 @@ class RutabagaStyle(object):
             type=self.type,
             state_definitions=',\n'.join(
                 [self.states[state].c_repr(state)
+                    for state in self.states]),
+            nprops=len(self.stylesheet.prop_ids),
+            state_indices=',\n'.join(
+                [self.states[state].c_index(state)
                     for state in self.states]))
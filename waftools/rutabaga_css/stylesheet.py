@@ -34,7 +34,7 @@ import sys
 from collections import OrderedDict
 
 from rutabaga_css.parser import *
-from rutabaga_css.style import RutabagaStyle
+from rutabaga_css.style import RutabagaStyle, builtin_props
 from rutabaga_css.font import *
 
 all = ["RutabagaStylesheet"]
@@ -65,9 +65,19 @@ class RutabagaStylesheet(object):
         self.fonts_used = 0
         self.fonts = {}
 
+        self.prop_ids = OrderedDict()
+        for prop in builtin_props:
+            self.prop_id(prop)
+
         if autoparse:
             self.parse()
 
+    def prop_id(self, name):
+        if name not in self.prop_ids:
+            self.prop_ids[name] = len(self.prop_ids)
+
+        return self.prop_ids[name]
+
     def parse_font_face(self, rule):
         decls = decl_dict(rule.declarations)
 
@@ -220,6 +230,17 @@ class RutabagaStylesheet(object):
 {style_structs}
 }};"""
 
+    c_prop_names_tpl = """\
+{{
+{names}
+\tNULL
+}};"""
+
+    def c_prop_names(self):
+        return self.c_prop_names_tpl.format(
+            names="\n".join(
+                ['\t"{0}",'.format(name) for name in self.prop_ids]))
+
     def c_repr(self, var_name):
         return self.c_repr_tpl.format(
             var_name=var_name,
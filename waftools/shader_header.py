@@ -27,9 +27,13 @@ def shader_header_feature(self):
 
 	tgt = self.path.get_bld().find_or_declare(self.target)
 	
-	vert = self.path.get_src().find_node(self.vertex)
-	frag = self.path.get_src().find_node(self.fragment)
-
-	self.create_task('glsl_to_c_header', src=[vert, frag], tgt=tgt)
+	# vertex=None writes out the fragment stage by itself, for variants
+	# that reuse another shader's vertex stage
+	src = [self.fragment]
+	if self.vertex:
+		src.insert(0, self.vertex)
+
+	src = [self.path.get_src().find_node(s) for s in src]
+	self.create_task('glsl_to_c_header', src=src, tgt=tgt)
 
 # vim: set ts=4 sts=4 sw=4 noet :